@@ -0,0 +1,125 @@
+#ifndef __AD9833_DRIVER_H__
+#define __AD9833_DRIVER_H__
+
+#include <Arduino.h>
+
+// AD9833 control register bits
+#define AD9833_B28 0x2000			// frequency registers take two consecutive 14 bit writes
+#define AD9833_HLB 0x1000
+#define AD9833_FSELECT 0x0800
+#define AD9833_PSELECT 0x0400
+#define AD9833_RESET 0x0100
+#define AD9833_SLEEP1 0x0080
+#define AD9833_SLEEP12 0x0040
+#define AD9833_OPBITEN 0x0020
+#define AD9833_DIV2 0x0008
+#define AD9833_MODE 0x0002
+#define AD9833_SELECT (AD9833_FSELECT | AD9833_PSELECT)
+
+// register address bits
+#define AD9833_FREQ0 0x4000
+#define AD9833_FREQ1 0x8000
+#define AD9833_PHASE0 0xC000
+#define AD9833_PHASE1 0xE000
+
+#define AD9833_MCLK 25000000UL
+#define AD9833_SPI_CLOCK 8000000UL
+
+// tuning word = frequency * 2^28 / MCLK, with the frequency in 1/10 Hz
+// the reciprocal of 10 * MCLK is held as a 64 bit fraction scaled by 2^91,
+// enough that frequencies up to 2^27 tenths round exactly
+#define AD9833_RECIPROCAL_SHIFT 91
+#define AD9833_WORD_SHIFT (AD9833_RECIPROCAL_SHIFT - 28)
+#define AD9833_TENTHS_DIVISOR (10UL * AD9833_MCLK)
+
+// floor and remainder of 2^bits / divisor, by long division at compile time
+constexpr uint64_t ad9833_quotient(byte bits, uint64_t divisor, uint64_t quotient=0, uint64_t remainder=1){
+	return bits == 0 ? quotient :
+		ad9833_quotient(bits - 1, divisor, (quotient << 1) | ((remainder << 1) >= divisor ? 1 : 0),
+			(remainder << 1) >= divisor ? (remainder << 1) - divisor : (remainder << 1));
+}
+
+constexpr uint64_t ad9833_remainder(byte bits, uint64_t divisor, uint64_t remainder=1){
+	return bits == 0 ? remainder :
+		ad9833_remainder(bits - 1, divisor, (remainder << 1) >= divisor ? (remainder << 1) - divisor : (remainder << 1));
+}
+
+// Register level access to one AD9833 over hardware SPI
+// GeneratorHandler writes precomputed words through this instead of the float based library calls
+// The output runs from one of two register sets, chosen by FSELECT and PSELECT together;
+// stage() loads the other set so commit() can switch several chips at once, and
+// hold() with release() restarts several chips with their phase accumulators aligned;
+// both take the mode along, it is set by the same control word
+// Every register is shadowed, writes of the value a register already holds are dropped
+class AD9833Driver
+{
+public:
+	AD9833Driver(uint8_t fsync_pin);
+
+	void begin(byte mode);
+	void set_mode(byte mode);
+	void set_frequency(byte reg, uint32_t tuning_word);
+	void set_phase(byte reg, uint16_t phase_word);
+	void write(uint16_t word);
+	byte active();
+
+	void stage(uint32_t tuning_word, uint16_t phase_word, byte mode);
+	static void commit(AD9833Driver **drivers, byte count);
+
+	void hold(byte mode);
+	static void release(AD9833Driver **drivers, byte count);
+
+	unsigned long words_issued();
+	unsigned long words_suppressed();
+	void reset_counts();
+
+	static constexpr uint32_t tuning_word(unsigned long frequency);
+	static unsigned long frequency(uint32_t tuning_word);
+	static uint16_t phase_word(unsigned int phase);
+	static uint16_t mode_bits(byte mode);
+
+	static const byte MODE_OFF = 0;
+	static const byte MODE_SINE = 1;
+	static const byte MODE_SQUARE1 = 2;	// square at the output frequency
+	static const byte MODE_SQUARE2 = 3;	// square at half the output frequency
+	static const byte MODE_TRIANGLE = 4;
+
+	static constexpr uint64_t FREQUENCY_RECIPROCAL =
+		ad9833_quotient(AD9833_RECIPROCAL_SHIFT, AD9833_TENTHS_DIVISOR) +
+		(ad9833_remainder(AD9833_RECIPROCAL_SHIFT, AD9833_TENTHS_DIVISOR) * 2 >= AD9833_TENTHS_DIVISOR ? 1 : 0);
+
+private:
+	uint8_t _fsync_pin;
+	uint16_t _control;
+	uint32_t _frequency[2];
+	uint16_t _phase[2];
+	byte _active;	// register set the output runs from
+	bool _staged;						// a control word waits for latch()
+	uint16_t _next_control;
+
+	static void latch(AD9833Driver **drivers, byte count);
+
+	unsigned long _issued;
+	unsigned long _suppressed;
+};
+
+// frequency in 1/10 Hz to the 28 bit FREQREG value, rounded to nearest
+// two 32x32 multiplies by the halves of the reciprocal, no division or float;
+// constexpr so tables of words can be worked out by the compiler
+constexpr uint32_t AD9833Driver::tuning_word(unsigned long frequency){
+	return (uint32_t)((((uint64_t)frequency * (uint32_t)(FREQUENCY_RECIPROCAL >> 32)) +
+		(((uint64_t)frequency * (uint32_t)FREQUENCY_RECIPROCAL + (1ULL << (AD9833_WORD_SHIFT - 1))) >> 32)) >>
+		(AD9833_WORD_SHIFT - 32)) & 0x0fffffffUL;
+}
+
+// the 1/10 Hz frequency a tuning word produces, for display
+inline unsigned long AD9833Driver::frequency(uint32_t tuning_word){
+	return (unsigned long)(((uint64_t)tuning_word * AD9833_TENTHS_DIVISOR + (1UL << 27)) >> 28);
+}
+
+// phase in 1/10 degree to the 12 bit PHASEREG value, 4096 / 3600 = 256 / 225
+inline uint16_t AD9833Driver::phase_word(unsigned int phase){
+	return (uint16_t)(((uint32_t)phase * 256UL + 112UL) / 225UL) & 0x0fff;
+}
+
+#endif
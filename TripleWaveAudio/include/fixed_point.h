@@ -0,0 +1,32 @@
+#ifndef __FIXED_POINT_H__
+#define __FIXED_POINT_H__
+
+#include <Arduino.h>
+
+// Rendering of values in 1/10 units, e.g. 12345 as "1234.5", without printf
+// Digits come from subtracting powers of ten, the ATmega328 has no divider and
+// every 32 bit division is a few hundred cycles of library code.
+// The text is right aligned in a field of width characters plus the terminator,
+// text wider than the field keeps its leading characters as the panel showed them.
+void format_fixed_point(long value, char *field, byte width);
+
+// A field on the panel that remembers the value it last rendered
+// render() formats only when the value changed, the text already in the LCD buffer
+// stands otherwise; changed() does the bookkeeping for fields formatted elsewhere
+class FixedPointField
+{
+public:
+	FixedPointField();
+
+	bool render(long value, char *field, byte width);
+	bool changed(long value);
+	void invalidate();
+
+	static const byte MAX_WIDTH = 10;
+
+private:
+	long _value;
+	bool _valid;
+};
+
+#endif
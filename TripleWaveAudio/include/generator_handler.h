@@ -1,63 +1,121 @@
 #ifndef __GENERATOR_HANDLER_H__
 #define __GENERATOR_HANDLER_H__
 
-// #include <Wire.h>
-// #include <hd44780.h>											 // main hd44780 header
-// #include <hd44780ioClass/hd44780_I2Cexp.h> // i2c expander i/o class header
-// #include <MD_AD9833.h>
+#include <Arduino.h>
+#include "lcd_buffer.h"
+#include "led_handler.h"
+#include "ad9833_driver.h"
+#include "fixed_point.h"
+#include "notes.h"
+
+// everything needed to bring a generator back, as kept in a preset
+struct GeneratorSettings {
+	long frequency;
+	int phase;
+	byte step;
+	byte mode;
+	byte state;
+};
+
+// one point of the velocity curve for frequency edits: detents arriving less than
+// interval ms apart are multiplied by multiplier
+struct AccelerationStep {
+	unsigned int interval;
+	byte multiplier;
+};
 
 class GeneratorHandler
 {
+	friend class SweepEngine;
+	friend class Sequencer;
+
 public:
-	GeneratorHandler(hd44780_I2Cexp *lcd, MD_AD9833 *generator, LEDHandler *handler, byte id, long frequency, byte step, int phase, MD_AD9833::mode_t mode, byte state);
+	GeneratorHandler(LCDBuffer *lcd, AD9833Driver *generator, LEDHandler *handler, byte id, long frequency, byte step, int phase, byte mode, byte state);
 	void silence();
 	void step_frequency(int steps);
 	void step_phase(int steps);
 	void step_step(int steps);
+	void step_note(int steps);
+	void turn(int steps, byte edit);
+	int accelerate(int steps, unsigned long time);
+	void toggle_edit();
 	void toggle_state(GeneratorHandler **handlers, int num_handlers=3);
 	void switch_to_normal(byte old_state, GeneratorHandler **handlers, int num_handlers);
 	void switch_to_muted(byte old_state, GeneratorHandler **handlers, int num_handlers);
 	void switch_to_solo(byte old_state, GeneratorHandler **handlers, int num_handlers);
 	void switch_to_sync(byte old_state, GeneratorHandler **handlers, int num_handlers);
 
+	void save_settings(GeneratorSettings *settings);
+	bool load_settings(const GeneratorSettings *settings);
+	bool set_frequency(long frequency);
+	bool set_phase(long phase);
+	bool set_step(long step);
+	bool set_mode(long mode);
+	bool set_state(long state);
+
 	void update_generator();
-	void decimalize(long value, char *buffer);
-	void show_right_aligned(byte col, byte row, const char *buffer, byte max_width);
+	static void update_generators(GeneratorHandler **handlers, int num_handlers);
+	static void restart_generators(GeneratorHandler **handlers, int num_handlers);
 	void show_centered(byte col, byte row, const char *buffer, byte max_width);
-	void show_fixed_point_long(long value, byte col, byte row, char *buffer, byte max_width);
+	bool show_fixed_point_long(FixedPointField *field, long value, byte col, byte row, char *buffer, byte max_width);
 	void show_frequency(byte col, byte row, char *buffer, byte max_width);
 	void show_led_per_state();
 	long step_to_frequency();
 	void show_step(byte col, byte row, char *buffer, byte max_width);
+	void show_note(byte col, byte row, char *buffer, byte max_width);
 	void show_phase(byte col, byte row, char *buffer, byte max_width);
 	void show_state(byte col, byte row, byte max_width);
 	void show_sep();
-	void show(bool last_handler=false);
+	void show();
+	void set_column(int column);
 
 	static const long MAX_FREQUENCY = 125000000L;
 	static const int MAX_STEP = 4;
 	static const int MAX_PHASE = 3600;
 	static const int HANDLER_WIDTH = 7;
+	static const int VISIBLE_COLUMNS = (LCDBuffer::COLS + 1) / HANDLER_WIDTH;
+	static const int NO_COLUMN = -1;
+	static const int MAX_HANDLERS = 4;
 	static const int STATE_NORMAL = 0;
 	static const int STATE_MUTED = 1;
 	static const int STATE_SYNC = 2;
 	static const int STATE_SOLO = 3;
+	static const byte EDIT_FREQUENCY = 0;
+	static const byte EDIT_NOTE = 1;		// by semitone, the step row names the note
+	static const byte EDIT_PHASE = 2;
+	static const int PHASE_STEP = 10;	// 1 degree per detent
 
 	byte _state;
+	byte _edit;			// what turning the encoder changes
 
 	private:
-	hd44780_I2Cexp *_lcd;
-	MD_AD9833 *_generator;
+	LCDBuffer *_lcd;
+	AD9833Driver *_generator;
 	LEDHandler *_handler;
 	byte _id;
 	long _frequency; // in 1/10 Hz
 	byte _step;			// in 1/10 Hz
 	int _phase;			// in 1/10 degree
-	MD_AD9833::mode_t _mode;
+	byte _mode;
 	long _silent_freq;
+	int _note;			// last stepped to, stands while _frequency is still its frequency
+	unsigned long _last_turn_time;
+	int _last_direction;
 
 	long _last_set_freq;
 	long _last_set_phase;
+	byte _last_set_mode;
+	bool _sweeping;	// the sweep engine or the sequencer owns the generator
+	int _column;		// on the panel, NO_COLUMN while scrolled off
+
+	int current_note();
+	uint32_t frequency_word();
+	void update_mode();
+
+	// the values on the panel, unchanged ones are not formatted again
+	FixedPointField _frequency_field;
+	FixedPointField _step_field;
+	FixedPointField _phase_field;
 };
 
 #endif
@@ -0,0 +1,61 @@
+#ifndef __LATENCY_TRACER_H__
+#define __LATENCY_TRACER_H__
+
+// Histograms of how long a turn takes to get from the knob to the generator and the LCD,
+// built only with -DTRACE_LATENCY like the encoder board's latency frames; without it
+// the tracer and its hooks in TripleWave.cpp compile to nothing and "T0"/"T1" are ignored
+// Turns are followed by their link sequence number through parsing, the generator commit
+// and the LCD flush. The encoder board's share arrives in a latency frame when it is built
+// with TRACE_LATENCY; the total is only known for turns that have one.
+// Buckets are powers of two of BUCKET_US, dump() prints them as text.
+
+#ifdef TRACE_LATENCY
+
+#include <Arduino.h>
+
+class LatencyTracer
+{
+public:
+	LatencyTracer();
+
+	void parsed(byte sequence, unsigned long received, unsigned long time);
+	void committed(unsigned long time);
+	void flushed(unsigned long time);
+	void encoder_latency(byte sequence, unsigned long latency);
+
+	unsigned int count(byte stage, byte bucket);
+	void dump(Print *out);
+	void reset();
+
+	static const byte STAGE_ENCODER = 0;	// detent to the frame on the wire, from the encoder board
+	static const byte STAGE_PARSE = 1;		// bytes taken from the UART to the command handed out
+	static const byte STAGE_COMMIT = 2;		// command to the generator written
+	static const byte STAGE_DISPLAY = 3;	// command to the LCD flushed
+	static const byte STAGE_TOTAL = 4;		// detent to the LCD flushed
+	static const byte NUM_STAGES = 5;
+
+	static const byte NUM_BUCKETS = 12;		// bucket n counts latencies below BUCKET_US << n, the last one the rest
+	static const unsigned int BUCKET_US = 64;
+	static const byte MAX_EVENTS = 8;			// turns followed at once, the oldest is given up
+
+private:
+	struct Event {
+		byte sequence;
+		byte flags;
+		unsigned long received;
+		unsigned long parsed;
+		unsigned long flushed;
+		unsigned long encoder;
+	};
+
+	void add(byte stage, unsigned long latency);
+	Event *find(byte sequence, byte flag);
+
+	Event _events[MAX_EVENTS];
+	byte _next_event;
+	unsigned int _histogram[NUM_STAGES][NUM_BUCKETS];
+};
+
+#endif
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef __LCD_BUFFER_H__
+#define __LCD_BUFFER_H__
+
+#include <Arduino.h>
+#include <hd44780.h>											 // main hd44780 header
+#include <hd44780ioClass/hd44780_I2Cexp.h> // i2c expander i/o class header
+
+// Shadow copy of the 20x4 panel
+// Renders land in RAM through the same setCursor()/write() calls as the LCD,
+// flush() then sends only the runs of cells that differ from what is displayed
+class LCDBuffer
+{
+public:
+	LCDBuffer(hd44780_I2Cexp *lcd);
+
+	void setCursor(byte col, byte row);
+	size_t write(uint8_t value);
+	size_t write(const char *buffer);
+	void fill(char value, byte count);
+
+	void flush();
+	void invalidate();
+
+	static const int COLS = 20;
+	static const int ROWS = 4;
+
+private:
+	hd44780_I2Cexp *_lcd;
+	byte _col;
+	byte _row;
+	char _pending[ROWS][COLS]; // what the panel should show
+	char _shown[ROWS][COLS];	 // what the panel is showing
+	bool _dirty[ROWS];
+};
+
+#endif
@@ -7,6 +7,10 @@
 // typedef uint8_t byte;
 
 // Handles activation and animation of panel and button LEDs
+// The pin and intensity tables are read from PROGMEM. The level of each LED is cached and
+// only a change reaches the pin, on/off pins are written through their port register.
+// Once attach_timer() is called, animation and flashes are stepped from the Timer2
+// overflow interrupt; the LEDs belong to the interrupt while an animation runs.
 class LEDHandler
 {
 public:
@@ -15,6 +19,10 @@ public:
 
 	void begin(unsigned long time, int style, int show_time=0, int blank_time=0, bool *enabled= NULL);
 	void step(unsigned long time);
+	void stop();
+
+	void attach_timer();
+	void tick();
 
 	void activate_leds(const volatile bool * states, bool mirror=false);
 	void activate_all(bool state=true, bool mirror=false);
@@ -26,6 +34,7 @@ public:
 
 	void activate_led(int virtual_pin, bool mirror=false);
 	void deactivate_led(int virtual_pin, bool mirror=false);
+	int num_leds();
 
 	static const int STYLE_PLAIN		= 0x00; // one LED at a time sequentially
 	static const int STYLE_RANDOM	 = 0x01; // one LED at a time randomly
@@ -33,15 +42,19 @@ public:
 	static const int STYLE_MIRROR	 = 0x04; // same output for panel and button LEDs
 	// for STYLE_MIRROR, the secondary LEDs mirroring the first are expected to be in the upper half of the set of LED pins
 	// static const int STYLE_STALLING = 0x08; // blanking period between rounds
-		// TODO add a style for all activated dur the show period
-		// TODO add a style for make before break showing style
 
 	static const int DEFAULT_SHOW_TIME	= 250;
 	static const int DEFAULT_BLANK_TIME = 250;
 	static const int DEFAULT_FLASH_TIME = 100;
 
+	static const int MAX_LEDS = 6;		// three panel LEDs and their mirrors
+
 private:
 
+	int pin(int virtual_pin);
+	int intensity(int virtual_pin);
+	void write_led(int virtual_pin, byte level);
+
 	const int *_led_pins;
 	int _num_leds;
 	const int *_intensity;	// array of ints matching led count, 0 for digitalWrite, 1-255 for analogWrite
@@ -57,17 +70,17 @@ private:
 	int _active;			// virtual current active led or other state
 	bool *_enabled;			// array of enabled leds for animation matching LED count
 
+	volatile bool _animating;
+	byte _levels[MAX_LEDS];		// 0 off, 255 fully on, PWM duty otherwise
+	byte _pwm;								// bit per LED with its timer output connected
+	volatile uint8_t *_ports[MAX_LEDS];
+	byte _masks[MAX_LEDS];
+
 	bool _flash_mirror;
 	int _flash_on_time;
-	bool _flash_state;
+	volatile bool _flash_state;
 	int _flash_pins;
 	unsigned long _next_flash_change;
 };
 
-// used to manage non-block LED flash
-// TODO move into the class
-#define FLASH_STATE_START 0
-#define FLASH_STATE_RUN	 1
-#define FLASH_STATE_DONE	2
-
 #endif
@@ -13,6 +13,7 @@
 #define LED_INTENSITY2 20 // Green panel LED is a bit brighter than the Amber LED
 #define LED_INTENSITY3 32 // Blue panel LED?
 
+// both in PROGMEM
 extern const int led_pins[];
 
 // array used to pass the LED intensities to LED handlers
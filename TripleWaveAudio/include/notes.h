@@ -0,0 +1,79 @@
+#ifndef __NOTES_H__
+#define __NOTES_H__
+
+#include <Arduino.h>
+#include "ad9833_driver.h"
+
+// equal temperament from C0 to B9, tuned to A4 in 1/10 Hz, e.g. -DNOTE_A4=4320
+#ifndef NOTE_A4
+#define NOTE_A4 4400L
+#endif
+
+static_assert(NOTE_A4 >= 4000L && NOTE_A4 <= 4800L, "NOTE_A4 is in 1/10 Hz");
+
+#define NUM_NOTES 120
+#define NOTE_A4_INDEX 57
+#define NO_NOTE -1
+
+// semitones within an octave
+#define NOTE_C 0
+#define NOTE_CS 1
+#define NOTE_D 2
+#define NOTE_DS 3
+#define NOTE_E 4
+#define NOTE_F 5
+#define NOTE_FS 6
+#define NOTE_G 7
+#define NOTE_GS 8
+#define NOTE_A 9
+#define NOTE_AS 10
+#define NOTE_B 11
+
+constexpr int note_index(byte semitone, byte octave){
+	return octave * 12 + semitone;
+}
+
+// 2^(semitones / 12) scaled by 2^31
+constexpr uint32_t semitone_ratio(byte semitones){
+	return semitones == 0 ? 2147483648UL : semitones == 1 ? 2275179671UL :
+		semitones == 2 ? 2410468894UL : semitones == 3 ? 2553802834UL :
+		semitones == 4 ? 2705659852UL : semitones == 5 ? 2866546760UL :
+		semitones == 6 ? 3037000500UL : semitones == 7 ? 3217589947UL :
+		semitones == 8 ? 3408917802UL : semitones == 9 ? 3611622603UL :
+		semitones == 10 ? 3826380858UL : 4053909305UL;
+}
+
+// semitones above the A at or below a note, and the octave of that A plus one
+constexpr byte note_above_a(int note){
+	return (note + 12 - NOTE_A) % 12;
+}
+
+constexpr byte note_a_octave(int note){
+	return (note + 12 - NOTE_A) / 12;
+}
+
+constexpr long note_round(uint64_t scaled, byte shift){
+	return (long)((scaled + (1ULL << (shift - 1))) >> shift);
+}
+
+// the frequency of a note in 1/10 Hz, rounded to nearest: the reference times the ratio
+// of the semitones above the A below, shifted by the octaves from A4 to that A;
+// integer only and constexpr, so the tables are worked out by the compiler
+constexpr long note_frequency(int note, long a4=NOTE_A4){
+	return note_round((uint64_t)a4 * semitone_ratio(note_above_a(note)),
+		31 + note_a_octave(NOTE_A4_INDEX) - note_a_octave(note));
+}
+
+static_assert(note_frequency(NOTE_A4_INDEX) == NOTE_A4, "A4 is the reference");
+
+// in PROGMEM, indexed by note
+extern const long note_frequencies[NUM_NOTES];
+extern const uint32_t note_words[NUM_NOTES];
+
+long note_to_frequency(int note);
+uint32_t note_to_word(int note);
+int note_at_or_below(long frequency);
+int nearest_note(long frequency);
+void format_note(int note, bool exact, char *field, byte width);
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef __PRESET_BANK_H__
+#define __PRESET_BANK_H__
+
+#include <Arduino.h>
+#include "generator_handler.h"
+
+// Presets of all generators in EEPROM
+// Slot 0 holds the last state for the boot-time restore, slots 1..PRESET_SLOTS are user presets.
+// Each slot owns an equal share of the EEPROM and writes go round-robin over the copies in
+// that share, the copy with the newest sequence number and a good checksum wins.
+// Writes go out one byte per service() call as the EEPROM becomes ready, so loop() never
+// waits out a 3.3 ms byte write; the last state is only written once things settle.
+class PresetBank
+{
+public:
+	PresetBank();
+
+	void begin();
+	bool recall(byte slot, GeneratorHandler **handlers, int num_handlers);
+	void store(byte slot);
+	void changed(unsigned long time);
+	void service(unsigned long time, GeneratorHandler **handlers, int num_handlers);
+	void flush(GeneratorHandler **handlers, int num_handlers);
+
+	static const byte LAST_STATE = 0;
+	static const byte PRESET_SLOTS = 4;
+	static const byte NUM_SLOTS = PRESET_SLOTS + 1;
+	static const byte MAX_GENERATORS = 4;
+	static const unsigned int SETTLE_TIME = 5000;	// ms without changes before the last state is saved
+
+private:
+	struct Record {
+		uint16_t sequence;
+		byte slot;
+		byte checksum;
+		GeneratorSettings generators[MAX_GENERATORS];
+	};
+
+	static byte checksum(const Record *record);
+	int address(byte slot, byte copy);
+	bool read(byte slot, byte copy, Record *record);
+	void start_write(byte slot, GeneratorHandler **handlers, int num_handlers);
+
+	byte _copies;										// per slot
+	byte _newest[NUM_SLOTS];				// copy holding the newest record, 0xff if none
+	uint16_t _sequence[NUM_SLOTS];
+
+	bool _dirty;
+	unsigned long _settle_time;
+	byte _store_slot;								// explicit store waiting, 0xff if none
+
+	Record _record;									// being written
+	int _write_address;
+	byte _write_index;							// next byte of _record, sizeof(Record) when idle
+};
+
+#endif
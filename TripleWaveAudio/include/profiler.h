@@ -0,0 +1,52 @@
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+// Section timing for the hot paths, built only with -DPROFILE_SECTIONS
+// PROFILE(section) at the top of a block times the rest of the block, min/max/total
+// microseconds and a call count per section go into a static table dumped by "T2".
+// Without the flag the macro and the table compile to nothing.
+// micros() stands in for Timer1 ticks, Timer1 is the sweep engine's 100 us tick.
+
+#define PROFILE_SHOW 0				// one per handler
+#define PROFILE_SHOW_SEP 4
+#define PROFILE_SERIAL_READ 5
+#define PROFILE_HANDLE 6
+#define PROFILE_HANDLE_SYNCED 7
+#define PROFILE_UPDATE_GENERATOR 8
+#define PROFILE_LCD_FLUSH 9
+#define PROFILE_NUM_SECTIONS 10
+
+#ifdef PROFILE_SECTIONS
+
+#include <Arduino.h>
+
+#define PROFILE(section) ProfileScope profile_scope_(section)
+
+void profiler_record(byte section, unsigned long elapsed);
+void profiler_dump(Print *out);
+void profiler_reset();
+
+class ProfileScope
+{
+public:
+	ProfileScope(byte section){
+		_section = section;
+		_start = micros();
+	}
+
+	~ProfileScope(){
+		profiler_record(_section, micros() - _start);
+	}
+
+private:
+	byte _section;
+	unsigned long _start;
+};
+
+#else
+
+#define PROFILE(section)
+
+#endif
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef __PROGMEM_H__
+#define __PROGMEM_H__
+
+#include <Arduino.h>
+
+// Typed reads of constant tables kept in flash with PROGMEM
+// On the ATmega328 a plain const table is copied into SRAM at startup,
+// a PROGMEM one stays in flash and has to be read back with these.
+
+template <typename T> T progmem_read(const T *address){
+	T value;
+	memcpy_P(&value, address, sizeof(T));
+	return value;
+}
+
+// copies a whole table entry, e.g. a string or a character bitmap, into RAM
+template <typename T, size_t N> void progmem_copy(T (&destination)[N], const T (&source)[N]){
+	memcpy_P(destination, source, sizeof(T) * N);
+}
+
+#endif
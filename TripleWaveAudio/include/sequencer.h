@@ -0,0 +1,69 @@
+#ifndef __SEQUENCER_H__
+#define __SEQUENCER_H__
+
+#include <Arduino.h>
+
+class GeneratorHandler;
+
+// one step of a sequence, kept in PROGMEM
+// The tuning word is worked out at compile time with AD9833Driver::tuning_word(), a step
+// with a duration of 0 takes effect together with the one after it, e.g. for chords
+struct SequenceStep {
+	uint32_t word;
+	uint16_t duration;	// ms until the next step
+	byte generator;
+	byte state;				// GeneratorHandler state, STATE_MUTED silences the generator
+};
+
+struct Sequence {
+	const SequenceStep *steps;	// PROGMEM
+	byte count;
+	bool loop;
+};
+
+// Plays a sequence of steps from the Timer1 compare B interrupt
+// Timer1 runs at SweepEngine::TICK_US as set up by SweepEngine::begin(), the sequencer only
+// enables its own compare interrupt while playing. A step boundary is one register write
+// to the chip, the chips of a chord are staged and switch over together on one control word;
+// the handlers of the generators taking part are brought up to date by refresh() at a low
+// rate, and stay out of the knob driven updates until the sequence ends.
+class Sequencer
+{
+public:
+	Sequencer();
+
+	void begin(GeneratorHandler **handlers, byte num_handlers);
+	bool start(const Sequence *sequence);
+	void stop();
+	bool running();
+	bool active(GeneratorHandler *handler);
+
+	void tick();
+	void refresh(unsigned long time);
+
+	static const byte MAX_HANDLERS = 4;
+	static const unsigned int DISPLAY_INTERVAL = 250;	// ms between display updates
+
+private:
+	void play_steps();
+	void finish();
+	void enable_timer(bool enable);
+
+	GeneratorHandler **_handlers;
+	byte _num_handlers;
+
+	const SequenceStep *_steps;
+	byte _count;
+	bool _loop;
+	byte _index;						// next step to play
+	volatile bool _running;
+	unsigned int _countdown;	// ms to the next step
+	byte _subticks;					// timer ticks to the next ms
+
+	byte _owned;						// bit per generator the sequence plays
+	uint32_t _words[MAX_HANDLERS];	// last played, for refresh()
+	byte _states[MAX_HANDLERS];
+	unsigned long _next_refresh;
+};
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef __SEQUENCES_H__
+#define __SEQUENCES_H__
+
+#include "sequencer.h"
+
+// the built in sequences, "Q<n>" plays sequence n from 1 and "Q0" stops
+#define NUM_SEQUENCES 3
+
+// in PROGMEM
+extern const Sequence sequences[NUM_SEQUENCES];
+
+#endif
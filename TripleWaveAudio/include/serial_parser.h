@@ -0,0 +1,92 @@
+#ifndef __SERIAL_PARSER_H__
+#define __SERIAL_PARSER_H__
+
+#include <Arduino.h>
+#include <link_frame.h>
+
+// event codes carried by a frame
+#define EVENT_DECREMENT 0
+#define EVENT_PRESS 1
+#define EVENT_INCREMENT 2
+#define EVENT_REPEAT 3
+#define EVENT_DELTA 4	// a coalesced turn of several detents, sent as "<id><sign><count>"
+#define EVENT_RECALL 5	// "P<slot>", the id is the preset slot
+#define EVENT_STORE 6		// "S<slot>"
+#define EVENT_TRACE 7		// "T0" dumps the latency histograms, "T1" clears them, "T2" dumps and clears the profile,
+												// each only in a build with TRACE_LATENCY or PROFILE_SECTIONS
+#define EVENT_LATENCY 8	// from a link latency frame, the id is its sequence number and steps the microseconds
+#define EVENT_SET 9			// "=<id><field><value>", an absolute setting, steps is the field and value() the value
+#define EVENT_BULK 10		// "[" opens a bulk of settings (id 1), "]" applies it (id 0)
+#define EVENT_SEQUENCE 11	// "Q<n>" plays built in sequence n from 1, "Q0" stops
+#define EVENT_SWEEP 12		// "W<id><shape>[R]" sweeps generator id as set up by the SET_SWEEP_* fields,
+												// steps is the shape plus SWEEP_REPEAT for an "R"; "W<id>X" stops
+
+// fields of EVENT_SET, frequency in 1/10 Hz and phase in 1/10 degree
+// e.g. "=0F1234.5" sets generator 0 to 1234.5 Hz, "=*A90" the phase of all to 90 degrees
+#define SET_FREQUENCY 0	// 'F'
+#define SET_PHASE 1			// 'A'
+#define SET_STEP 2			// 'I', step number 0-4
+#define SET_MODE 3			// 'M', AD9833Driver mode 0-4
+#define SET_STATE 4			// 'S', 0 normal, 1 muted, 2 sync, 3 solo
+#define SET_SWEEP_START 5	// 'B', where the next sweep begins, in 1/10 Hz
+#define SET_SWEEP_END 6		// 'E', where it ends, in 1/10 Hz
+#define SET_SWEEP_STEPS 7	// 'N', steps from start to end
+#define SET_SWEEP_DWELL 8	// 'D', microseconds on each step
+#define SET_ALL -1			// "*" in place of the id
+
+// shapes of EVENT_SWEEP, e.g. "W0G" one logarithmic sweep of generator 0, "W1LR" repeating linear ones
+#define SWEEP_LINEAR 0	// 'L'
+#define SWEEP_LOG 1			// 'G'
+#define SWEEP_STOP 2		// 'X'
+#define SWEEP_REPEAT 4	// added for a trailing 'R'
+
+// Non-blocking reader for the binary link frames sent by the encoder board, and for
+// "<id><data>\r\n" text frames typed from a host; text frames cannot reach id 3 (reset)
+// A host can also set values outright with EVENT_SET frames, bracketed by "[" and "]"
+// to have several of them take effect together, and run frequency sweeps set up the same way
+// receive() drains whatever the UART holds into a ring buffer without waiting,
+// next_command() hands out complete frames; partial frames carry over to the next pass
+class SerialParser
+{
+public:
+	SerialParser(HardwareSerial *serial);
+
+	void receive();
+	bool next_command(int &id, int &data, int &steps);
+
+	unsigned int malformed_count();
+	unsigned int overflowed_count();
+	LinkReceiver *link();
+	int last_sequence();
+	unsigned long received_time();
+	long value();
+	void reset_counts();
+
+	static const byte RING_SIZE = 64; // power of two
+	static const byte FRAME_SIZE = 13;	// longest valid frame, "=*F12500000.0", without line endings
+
+private:
+	bool parse_frame(int &id, int &data, int &steps);
+	bool parse_link(int &id, int &data, int &steps);
+	bool parse_setting(int &id, int &data, int &steps);
+	bool parse_sweep(int &id, int &data, int &steps);
+
+	HardwareSerial *_serial;
+	byte _ring[RING_SIZE];
+	byte _head;
+	byte _tail;
+
+	char _frame[FRAME_SIZE];
+	byte _length;
+	bool _overflowed;
+
+	LinkReceiver _link;
+	int _last_sequence;					// of the last command, -1 for a text frame
+	unsigned long _received_time;	// micros() of the last receive() that took bytes
+	long _value;									// of the last EVENT_SET
+
+	unsigned int _malformed_count;
+	unsigned int _overflowed_count;
+};
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef __SWEEP_ENGINE_H__
+#define __SWEEP_ENGINE_H__
+
+#include <Arduino.h>
+
+class GeneratorHandler;
+class AD9833Driver;
+
+// Frequency sweeps stepped from the Timer1 compare interrupt
+// start() works out the per step tuning word change once; a tick then only adds
+// (linear) or multiplies by a fixed point ratio (logarithmic) and writes the register.
+// The swept handler's display is brought up to date by refresh() at a low rate.
+class SweepEngine
+{
+public:
+	SweepEngine();
+
+	void begin();
+	bool start(GeneratorHandler *handler, long start_frequency, long end_frequency, unsigned int steps, unsigned long dwell, byte shape, bool repeat=false);
+	void stop(GeneratorHandler *handler);
+	bool active(GeneratorHandler *handler);
+
+	void tick();
+	void refresh(unsigned long time);
+
+	static const byte SHAPE_LINEAR = 0;
+	static const byte SHAPE_LOG = 1;
+
+	static const int MAX_SWEEPS = 4;
+	static const unsigned int TICK_US = 100;					// dwell resolution
+	static const unsigned long MAX_DWELL = 65535UL * TICK_US;	// in microseconds, a 16 bit count of ticks
+	static const unsigned int DISPLAY_INTERVAL = 250;	// ms between display updates
+
+private:
+	struct Sweep {
+		GeneratorHandler *handler;
+		AD9833Driver *generator;
+		bool running;
+		bool repeat;
+		byte shape;
+		unsigned int steps;
+		unsigned int step;
+		unsigned int dwell;			// in ticks
+		unsigned int countdown;
+		uint32_t start_word;
+		uint32_t end_word;
+		uint32_t word;
+		long end_frequency;
+		// linear: whole increment per step plus a Bresenham remainder
+		int32_t increment;
+		uint32_t remainder;
+		uint32_t error;
+		// logarithmic: word scaled by 2^32, ratio scaled by 2^28
+		uint64_t scaled_word;
+		uint32_t ratio;
+	};
+
+	void advance(Sweep *sweep);
+	void finish(Sweep *sweep);
+	void enable_timer(bool enable);
+
+	Sweep _sweeps[MAX_SWEEPS];
+	volatile byte _running;
+	unsigned long _next_refresh;
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef __TASK_SCHEDULER_H__
+#define __TASK_SCHEDULER_H__
+
+#include <Arduino.h>
+
+typedef void (*TaskFunc)(unsigned long time);
+
+// Cooperative scheduler for a fixed set of tasks, called from loop()
+// Each task has a period and the deadline of its next run; a pass runs every task that is
+// due, in the order they were added, so earlier tasks have the higher priority.
+// A task with a period of 0 only runs when triggered. A late task is not run again to
+// catch up, its next deadline is one period on from when it did run.
+// When a pass finds nothing due, idle() sleeps until the next interrupt.
+class TaskScheduler
+{
+public:
+	TaskScheduler();
+
+	byte add(TaskFunc func, unsigned int period, bool enabled=true);
+	void enable(byte task, bool enabled=true);
+	void trigger(byte task);
+	bool run(unsigned long time);
+	void idle();
+
+	unsigned long lateness(byte task);
+	void reset_counts();
+
+	static const byte MAX_TASKS = 8;
+
+private:
+	struct Task {
+		TaskFunc func;
+		unsigned int period;			// ms, 0 for triggered only
+		unsigned long deadline;
+		bool enabled;
+		bool triggered;
+		unsigned long lateness;		// worst ms past the deadline when run
+	};
+
+	bool due(Task *task, unsigned long time);
+
+	Task _tasks[MAX_TASKS];
+	byte _num_tasks;
+};
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef __UNROLL_H__
+#define __UNROLL_H__
+
+// Calls f(0) .. f(N-1) as N inline calls, for the per-generator loops where N is the
+// generator count of the build. The loop counter and its compare disappear and each
+// call sees its index as a constant.
+template <int N> struct Unroll
+{
+	template <typename F> static inline __attribute__((always_inline)) void each(F f){
+		Unroll<N - 1>::each(f);
+		f(N - 1);
+	}
+};
+
+template <> struct Unroll<0>
+{
+	template <typename F> static inline __attribute__((always_inline)) void each(F f){
+	}
+};
+
+#endif
@@ -0,0 +1,184 @@
+#include <chrono>
+#include "Arduino.h"
+
+MockBus mock_bus;
+byte mock_pin_state[NUM_DIGITAL_PINS];
+byte mock_pin_value[NUM_DIGITAL_PINS];
+
+static const std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+static unsigned long long skipped_us = 0;
+
+void mock_reset_counters(){
+	memset(&mock_bus, 0, sizeof(mock_bus));
+}
+
+void mock_advance_time(unsigned long ms){
+	skipped_us += ms * 1000ULL;
+}
+
+void pinMode(uint8_t pin, uint8_t mode){
+	if(pin < NUM_DIGITAL_PINS)
+		mock_pin_state[pin] = mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value){
+	mock_bus.pin_writes++;
+	if(pin < NUM_DIGITAL_PINS)
+		mock_pin_value[pin] = value ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin){
+	if(pin < NUM_DIGITAL_PINS)
+		return mock_pin_value[pin];
+	return LOW;
+}
+
+void analogWrite(uint8_t pin, int value){
+	mock_bus.pin_writes++;
+	if(pin < NUM_DIGITAL_PINS)
+		mock_pin_value[pin] = value ? HIGH : LOW;
+}
+
+void shiftOut(uint8_t data_pin, uint8_t clock_pin, uint8_t bit_order, uint8_t value){
+	// 8 data bits and 16 clock edges
+	mock_bus.pin_writes += 24;
+}
+
+unsigned long micros(){
+	std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start_time;
+	return (unsigned long)(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() + skipped_us);
+}
+
+unsigned long millis(){
+	return micros() / 1000UL;
+}
+
+void delay(unsigned long ms){
+	mock_advance_time(ms);
+}
+
+void delayMicroseconds(unsigned int us){
+	skipped_us += us;
+}
+
+long random(long howbig){
+	if(howbig == 0)
+		return 0;
+	return rand() % howbig;
+}
+
+long random(long howsmall, long howbig){
+	if(howsmall >= howbig)
+		return howsmall;
+	return howsmall + random(howbig - howsmall);
+}
+
+void randomSeed(unsigned long seed){
+	srand(seed);
+}
+
+size_t Print::write(const char *str){
+	if(str == NULL)
+		return 0;
+	return write((const uint8_t *)str, strlen(str));
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size){
+	size_t n = 0;
+	while(size--)
+		n += write(*buffer++);
+	return n;
+}
+
+size_t Print::print(const char *str){
+	return write(str);
+}
+
+size_t Print::print(long value){
+	char buffer[12];
+	sprintf(buffer, "%ld", value);
+	return write(buffer);
+}
+
+size_t Print::println(const char *str){
+	size_t n = print(str);
+	return n + write("\r\n");
+}
+
+size_t Print::println(long value){
+	size_t n = print(value);
+	return n + write("\r\n");
+}
+
+HardwareSerial Serial;
+
+HardwareSerial::HardwareSerial(){
+	_head = 0;
+	_tail = 0;
+	_timeout = 1000;
+}
+
+void HardwareSerial::begin(unsigned long baud){
+}
+
+void HardwareSerial::setTimeout(unsigned long timeout){
+	_timeout = timeout;
+}
+
+int HardwareSerial::available(){
+	return _tail - _head;
+}
+
+int HardwareSerial::peek(){
+	if(_head == _tail)
+		return -1;
+	return _input[_head];
+}
+
+int HardwareSerial::read(){
+	if(_head == _tail)
+		return -1;
+	mock_bus.serial_rx++;
+	int c = _input[_head++];
+	if(_head == _tail)
+		_head = _tail = 0;
+	return c;
+}
+
+// Stream::readBytesUntil() semantics: running out of input before the terminator
+// means the real thing sits in timedRead() for the whole timeout
+size_t HardwareSerial::readBytesUntil(char terminator, char *buffer, size_t length){
+	size_t index = 0;
+	while(index < length){
+		int c = read();
+		if(c < 0){
+			mock_bus.serial_stalls++;
+			mock_advance_time(_timeout);
+			break;
+		}
+		if(c == terminator)
+			break;
+		buffer[index++] = (char)c;
+	}
+	return index;
+}
+
+size_t HardwareSerial::write(uint8_t c){
+	mock_bus.serial_tx++;
+	return 1;
+}
+
+void HardwareSerial::inject(const char *data){
+	inject((const uint8_t *)data, strlen(data));
+}
+
+void HardwareSerial::inject(const uint8_t *data, size_t size){
+	if(size > INPUT_SIZE - _tail)
+		size = INPUT_SIZE - _tail;
+	memcpy(_input + _tail, data, size);
+	_tail += size;
+}
+
+void HardwareSerial::clear_input(){
+	_head = _tail = 0;
+}
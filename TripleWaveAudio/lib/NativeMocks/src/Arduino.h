@@ -0,0 +1,122 @@
+#ifndef __ARDUINO_H__
+#define __ARDUINO_H__
+
+// Host stand-in for the Arduino core, used by the native environment only
+// Pin and serial activity is counted in mock_bus so the hot path can be measured off target
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW	0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+#define NUM_DIGITAL_PINS 20
+
+// bus activity counters, shared by all of the stand-ins
+struct MockBus {
+	unsigned long i2c_bytes;		// bytes on the wire to the LCD expander, address bytes included
+	unsigned long lcd_commands; // hd44780 instructions (setCursor, createChar etc.)
+	unsigned long lcd_data;			// hd44780 character writes
+	unsigned long spi_words;		// 16 bit words clocked into the AD9833s
+	unsigned long pin_writes;		// digitalWrite/analogWrite calls
+	unsigned long serial_rx;		// bytes consumed from Serial
+	unsigned long serial_tx;		// bytes sent to Serial
+	unsigned long serial_stalls; // reads that would have waited out the Stream timeout
+	unsigned long eeprom_writes; // bytes actually programmed
+};
+
+extern MockBus mock_bus;
+void mock_reset_counters();
+
+// the clock runs on real time plus any time the firmware would have spent blocked
+void mock_advance_time(unsigned long ms);
+extern byte mock_pin_state[NUM_DIGITAL_PINS];
+extern byte mock_pin_value[NUM_DIGITAL_PINS];
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+void shiftOut(uint8_t data_pin, uint8_t clock_pin, uint8_t bit_order, uint8_t value);
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+// flash and RAM share one address space on the host
+#define PROGMEM
+#define PSTR(s) (s)
+#define memcpy_P memcpy
+#define strcpy_P strcpy
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+
+// there are no interrupts on the host, timer handlers are called directly by the tests
+#define noInterrupts()
+#define interrupts()
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+#define min(a,b) ((a)<(b)?(a):(b))
+#define max(a,b) ((a)>(b)?(a):(b))
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+
+class Print
+{
+public:
+	virtual ~Print(){}
+	virtual size_t write(uint8_t c) = 0;
+	size_t write(const char *str);
+	size_t write(const uint8_t *buffer, size_t size);
+	size_t print(const char *str);
+	size_t print(long value);
+	size_t println(const char *str="");
+	size_t println(long value);
+};
+
+// Serial input is scripted: inject() queues bytes that available()/read() hand out
+class HardwareSerial : public Print
+{
+public:
+	HardwareSerial();
+	void begin(unsigned long baud);
+	void setTimeout(unsigned long timeout);
+	int available();
+	int peek();
+	int read();
+	size_t readBytesUntil(char terminator, char *buffer, size_t length);
+	size_t write(uint8_t c);
+	using Print::write;
+
+	void inject(const char *data);
+	void inject(const uint8_t *data, size_t size);
+	void clear_input();
+
+	static const size_t INPUT_SIZE = 4096;
+
+private:
+	uint8_t _input[INPUT_SIZE];
+	size_t _head;
+	size_t _tail;
+	unsigned long _timeout;
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,29 @@
+#include "EEPROM.h"
+
+EEPROMClass EEPROM;
+
+EEPROMClass::EEPROMClass(){
+	erase();
+}
+
+uint8_t EEPROMClass::read(int idx){
+	return _data[idx & E2END];
+}
+
+void EEPROMClass::write(int idx, uint8_t value){
+	mock_bus.eeprom_writes++;
+	_data[idx & E2END] = value;
+}
+
+void EEPROMClass::update(int idx, uint8_t value){
+	if(read(idx) != value)
+		write(idx, value);
+}
+
+uint16_t EEPROMClass::length(){
+	return E2END + 1;
+}
+
+void EEPROMClass::erase(){
+	memset(_data, 0xff, sizeof(_data));
+}
@@ -0,0 +1,44 @@
+#ifndef __EEPROM_H__
+#define __EEPROM_H__
+
+// Host stand-in for the EEPROM library, used by the native environment only
+// Starts erased, like a new ATmega328; programmed bytes are counted in mock_bus
+
+#include <Arduino.h>
+
+#define E2END 0x3FF
+
+// writes complete at once on the host
+#define eeprom_is_ready() (1)
+
+class EEPROMClass
+{
+public:
+	EEPROMClass();
+	uint8_t read(int idx);
+	void write(int idx, uint8_t value);
+	void update(int idx, uint8_t value);
+	uint16_t length();
+	void erase();
+
+	template <typename T> T &get(int idx, T &t){
+		uint8_t *ptr = (uint8_t *)&t;
+		for(size_t i = 0; i < sizeof(T); i++)
+			ptr[i] = read(idx + i);
+		return t;
+	}
+
+	template <typename T> const T &put(int idx, const T &t){
+		const uint8_t *ptr = (const uint8_t *)&t;
+		for(size_t i = 0; i < sizeof(T); i++)
+			update(idx + i, ptr[i]);
+		return t;
+	}
+
+private:
+	uint8_t _data[E2END + 1];
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
@@ -0,0 +1,33 @@
+#include "SPI.h"
+
+SPIClass SPI;
+
+void SPIClass::begin(){
+	log_count = 0;
+}
+
+void SPIClass::end(){
+}
+
+void SPIClass::usingInterrupt(uint8_t interrupt_number){
+}
+
+void SPIClass::beginTransaction(SPISettings settings){
+}
+
+void SPIClass::endTransaction(){
+}
+
+uint8_t SPIClass::transfer(uint8_t data){
+	return 0;
+}
+
+uint16_t SPIClass::transfer16(uint16_t data){
+	mock_bus.spi_words++;
+	if(log_count == LOG_SIZE){
+		memmove(log, log + 1, sizeof(log[0]) * (LOG_SIZE - 1));
+		log_count--;
+	}
+	log[log_count++] = data;
+	return 0;
+}
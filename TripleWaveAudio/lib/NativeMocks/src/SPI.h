@@ -0,0 +1,39 @@
+#ifndef __SPI_H__
+#define __SPI_H__
+
+// Host stand-in for the SPI library, used by the native environment only
+
+#include <Arduino.h>
+
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x04
+#define SPI_MODE2 0x08
+#define SPI_MODE3 0x0C
+
+class SPISettings
+{
+public:
+	SPISettings(){}
+	SPISettings(uint32_t clock, uint8_t bit_order, uint8_t data_mode){}
+};
+
+class SPIClass
+{
+public:
+	void begin();
+	void end();
+	void usingInterrupt(uint8_t interrupt_number);
+	void beginTransaction(SPISettings settings);
+	void endTransaction();
+	uint8_t transfer(uint8_t data);
+	uint16_t transfer16(uint16_t data);
+
+	// the last words clocked out, oldest first
+	static const int LOG_SIZE = 16;
+	uint16_t log[LOG_SIZE];
+	int log_count;
+};
+
+extern SPIClass SPI;
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef __WIRE_H__
+#define __WIRE_H__
+
+// Host stand-in for Wire, used by the native environment only
+// LCD traffic is counted by the hd44780 stand-in
+
+#include <Arduino.h>
+
+#endif
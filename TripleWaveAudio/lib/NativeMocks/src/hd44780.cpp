@@ -0,0 +1,111 @@
+#include "hd44780.h"
+
+hd44780::hd44780(){
+	_cols = MAX_COLS;
+	_rows = MAX_ROWS;
+	_col = 0;
+	_row = 0;
+	_display = true;
+	_backlight = true;
+	clear();
+}
+
+int hd44780::begin(uint8_t cols, uint8_t rows){
+	_cols = cols > MAX_COLS ? MAX_COLS : cols;
+	_rows = rows > MAX_ROWS ? MAX_ROWS : rows;
+	return clear();
+}
+
+int hd44780::clear(){
+	command(0x01);
+	for(int row = 0; row < MAX_ROWS; row++){
+		memset(_ddram[row], ' ', MAX_COLS);
+		_ddram[row][MAX_COLS] = '\0';
+	}
+	_col = 0;
+	_row = 0;
+	return 0;
+}
+
+int hd44780::home(){
+	command(0x02);
+	_col = 0;
+	_row = 0;
+	return 0;
+}
+
+// like the library, rows past the end land on the last row
+int hd44780::setCursor(uint8_t col, uint8_t row){
+	if(row >= _rows)
+		row = _rows - 1;
+	command(0x80 | col);
+	_col = col;
+	_row = row;
+	return 0;
+}
+
+int hd44780::createChar(uint8_t charval, uint8_t charmap[]){
+	command(0x40 | ((charval & 0x7) << 3));
+	for(int i = 0; i < 8; i++){
+		mock_bus.i2c_bytes += I2C_BYTES_PER_TRANSFER;
+		mock_bus.lcd_data++;
+	}
+	return 0;
+}
+
+int hd44780::display(){
+	command(0x0c);
+	_display = true;
+	return 0;
+}
+
+int hd44780::noDisplay(){
+	command(0x08);
+	_display = false;
+	return 0;
+}
+
+// the backlight is a bit on the expander, one byte on the wire
+int hd44780::backlight(){
+	mock_bus.i2c_bytes += 2;
+	_backlight = true;
+	return 0;
+}
+
+int hd44780::noBacklight(){
+	mock_bus.i2c_bytes += 2;
+	_backlight = false;
+	return 0;
+}
+
+bool hd44780::is_on(){
+	return _display && _backlight;
+}
+
+size_t hd44780::write(uint8_t value){
+	mock_bus.i2c_bytes += I2C_BYTES_PER_TRANSFER;
+	mock_bus.lcd_data++;
+	if(_col < _cols)
+		_ddram[_row][_col] = (char)value;
+	_col++;
+	return 1;
+}
+
+void hd44780::fatalError(int status){
+	fprintf(stderr, "hd44780 fatal error %d\n", status);
+	exit(status);
+}
+
+char hd44780::cell(uint8_t col, uint8_t row){
+	return _ddram[row][col];
+}
+
+const char *hd44780::row_text(uint8_t row){
+	_ddram[row][_cols] = '\0';
+	return _ddram[row];
+}
+
+void hd44780::command(uint8_t value){
+	mock_bus.i2c_bytes += I2C_BYTES_PER_TRANSFER;
+	mock_bus.lcd_commands++;
+}
@@ -0,0 +1,50 @@
+#ifndef __HD44780_H__
+#define __HD44780_H__
+
+// Host stand-in for the hd44780 library, used by the native environment only
+// Keeps a copy of DDRAM so tests can read the panel back
+
+#include <Arduino.h>
+
+class hd44780 : public Print
+{
+public:
+	hd44780();
+	int begin(uint8_t cols, uint8_t rows);
+	int clear();
+	int home();
+	int setCursor(uint8_t col, uint8_t row);
+	int createChar(uint8_t charval, uint8_t charmap[]);
+	int display();
+	int noDisplay();
+	int backlight();
+	int noBacklight();
+	size_t write(uint8_t value);
+	using Print::write;
+
+	static void fatalError(int status);
+
+	// test access
+	char cell(uint8_t col, uint8_t row);
+	const char *row_text(uint8_t row);
+	bool is_on();
+
+	static const int MAX_COLS = 20;
+	static const int MAX_ROWS = 4;
+
+	// a 4 bit transfer through the PCF8574 backpack: address byte plus E high/low for each nibble
+	static const int I2C_BYTES_PER_TRANSFER = 5;
+
+protected:
+	void command(uint8_t value);
+
+	uint8_t _cols;
+	uint8_t _rows;
+	uint8_t _col;
+	uint8_t _row;
+	bool _display;
+	bool _backlight;
+	char _ddram[MAX_ROWS][MAX_COLS + 1];
+};
+
+#endif
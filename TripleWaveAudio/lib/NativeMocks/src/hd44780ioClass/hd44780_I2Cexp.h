@@ -0,0 +1,10 @@
+#ifndef __HD44780_I2CEXP_H__
+#define __HD44780_I2CEXP_H__
+
+#include <hd44780.h>
+
+class hd44780_I2Cexp : public hd44780
+{
+};
+
+#endif
@@ -1,29 +1,72 @@
 #include <Wire.h>
 #include <hd44780.h>											 // main hd44780 header
 #include <hd44780ioClass/hd44780_I2Cexp.h> // i2c expander i/o class header
-#include <MD_AD9833.h>
 #include <SPI.h>
 #include "leds.h"
+#include "lcd_buffer.h"
+#include "ad9833_driver.h"
+#include "serial_parser.h"
+#include "sweep_engine.h"
+#include "sequencer.h"
+#include "sequences.h"
+#include "preset_bank.h"
+#include "task_scheduler.h"
+#include "latency_tracer.h"
+#include "profiler.h"
+#include "progmem.h"
 #include "generator_handler.h"
+#include "unroll.h"
 
 hd44780_I2Cexp lcd; // declare lcd object: auto locate & auto config expander chip
 
+// handlers render into the shadow buffer, loop() flushes the changes to the LCD
+LCDBuffer display(&lcd);
+
 // LCD geometry
 const int LCD_COLS = 20;
 const int LCD_ROWS = 4;
 
-// Pins for SPI comm with the AD9833 IC
+// custom characters 1-3 for the separators, show_sep() uses 1 at the top down to 3 at the bottom
+#define NUM_SEPARATOR_CHARS 3
+const uint8_t separator_chars[NUM_SEPARATOR_CHARS][8] PROGMEM = {
+	{0x04,0x04,0x04,0x04,0x04,0x04,0x04,0x04},	// line
+	{0x04,0x00,0x04,0x00,0x04,0x00,0x04,0x00},	// dots
+	{0x04,0x00,0x00,0x00,0x04,0x00,0x00,0x00}		// far dots
+	// {0x00,0x00,0x00,0x00,0x04,0x00,0x00,0x00}	// far far dots
+
+	// vertical brackets
+	// {0x0e,0x04,0x04,0x04,0x04,0x04,0x04,0x04}	// top
+	// {0x04,0x04,0x04,0x04,0x04,0x04,0x04,0x04}	// middle
+	// {0x04,0x04,0x04,0x04,0x04,0x04,0x04,0x0e}	// bottom
+};
+
+// Pins for SPI comm with the AD9833 IC, DATA and CLK are the hardware SPI MOSI and SCK
 const uint8_t PIN_DATA = 11;	///< SPI Data pin number
 const uint8_t PIN_CLK = 13;		///< SPI Clock pin number
 const uint8_t PIN_FSYNC1 = 10; ///< SPI Load pin number (FSYNC in AD9833 usage)
 const uint8_t PIN_FSYNC2 = 9;	///< SPI Load pin number (FSYNC in AD9833 usage)
 const uint8_t PIN_FSYNC3 = 8;	///< SPI Load pin number (FSYNC in AD9833 usage)
-// const uint8_t PIN_FSYNC4 = 7;	///< SPI Load pin number (FSYNC in AD9833 usage)
+const uint8_t PIN_FSYNC4 = 7;	///< SPI Load pin number (FSYNC in AD9833 usage)
 
-MD_AD9833	AD1(PIN_DATA, PIN_CLK, PIN_FSYNC1); // Arbitrary SPI pins
-MD_AD9833	AD2(PIN_DATA, PIN_CLK, PIN_FSYNC2); // Arbitrary SPI pins
-MD_AD9833	AD3(PIN_DATA, PIN_CLK, PIN_FSYNC3); // Arbitrary SPI pins
-// MD_AD9833	AD4(PIN_DATA, PIN_CLK, PIN_FSYNC4); // Arbitrary SPI pins
+// generators on this board, build with -DNUM_HANDLERS=4 for the fourth AD9833 on PIN_FSYNC4
+#ifndef NUM_HANDLERS
+#define NUM_HANDLERS 3
+#endif
+
+static_assert(NUM_HANDLERS >= 1 && NUM_HANDLERS <= 4, "one to four generators");
+static_assert(NUM_HANDLERS <= PresetBank::MAX_GENERATORS, "presets hold every generator");
+static_assert(NUM_HANDLERS <= GeneratorHandler::MAX_HANDLERS, "synced updates stage every generator");
+
+AD9833Driver AD1(PIN_FSYNC1);
+#if NUM_HANDLERS > 1
+AD9833Driver AD2(PIN_FSYNC2);
+#endif
+#if NUM_HANDLERS > 2
+AD9833Driver AD3(PIN_FSYNC3);
+#endif
+#if NUM_HANDLERS > 3
+AD9833Driver AD4(PIN_FSYNC4);
+#endif
 
 // #define SILENTFREQ 100000.0
 
@@ -34,118 +77,498 @@ MD_AD9833	AD3(PIN_DATA, PIN_CLK, PIN_FSYNC3); // Arbitrary SPI pins
 // 	// AD4.setFrequency(0, SILENT_FREQ);
 // }
 
-// handler IDs are 1 based
-#define NUM_HANDLERS 3
-
-// for portable
-// GeneratorHandler handler1(&lcd, &AD1, &panel_leds, 0, 5233L, 2, 0, MD_AD9833::MODE_SINE, GeneratorHandler::STATE_MUTED);
-// GeneratorHandler handler2(&lcd, &AD2, &panel_leds, 1, 6593L, 2, 0, MD_AD9833::MODE_SINE, GeneratorHandler::STATE_MUTED);
-// GeneratorHandler handler3(&lcd, &AD3, &panel_leds, 2, 7939L, 2, 0, MD_AD9833::MODE_SINE, GeneratorHandler::STATE_MUTED);
+// for portable, a C major chord
+// GeneratorHandler handler1(&display, &AD1, &panel_leds, 0, note_frequency(note_index(NOTE_C, 5)), 2, 0, AD9833Driver::MODE_SINE, GeneratorHandler::STATE_MUTED);
+// GeneratorHandler handler2(&display, &AD2, &panel_leds, 1, note_frequency(note_index(NOTE_E, 5)), 2, 0, AD9833Driver::MODE_SINE, GeneratorHandler::STATE_MUTED);
+// GeneratorHandler handler3(&display, &AD3, &panel_leds, 2, note_frequency(note_index(NOTE_G, 5)), 2, 0, AD9833Driver::MODE_SINE, GeneratorHandler::STATE_MUTED);
 
 // for desktop
-GeneratorHandler handler1(&lcd, &AD1, &panel_leds, 0, 10L, 1, 0, MD_AD9833::MODE_SQUARE1, GeneratorHandler::STATE_MUTED);
-GeneratorHandler handler2(&lcd, &AD2, &panel_leds, 1, 100L, 1, 0, MD_AD9833::MODE_SQUARE1, GeneratorHandler::STATE_MUTED);
-GeneratorHandler handler3(&lcd, &AD3, &panel_leds, 2, 1000L, 1, 0, MD_AD9833::MODE_SQUARE1, GeneratorHandler::STATE_MUTED);
-
-GeneratorHandler *handlers[NUM_HANDLERS] = {&handler1, &handler2, &handler3};
+GeneratorHandler handler1(&display, &AD1, &panel_leds, 0, 10L, 1, 0, AD9833Driver::MODE_SQUARE1, GeneratorHandler::STATE_MUTED);
+#if NUM_HANDLERS > 1
+GeneratorHandler handler2(&display, &AD2, &panel_leds, 1, 100L, 1, 0, AD9833Driver::MODE_SQUARE1, GeneratorHandler::STATE_MUTED);
+#endif
+#if NUM_HANDLERS > 2
+GeneratorHandler handler3(&display, &AD3, &panel_leds, 2, 1000L, 1, 0, AD9833Driver::MODE_SQUARE1, GeneratorHandler::STATE_MUTED);
+#endif
+#if NUM_HANDLERS > 3
+GeneratorHandler handler4(&display, &AD4, &panel_leds, 3, 10000L, 1, 0, AD9833Driver::MODE_SQUARE1, GeneratorHandler::STATE_MUTED);
+#endif
+
+GeneratorHandler *handlers[NUM_HANDLERS] = {
+	&handler1,
+#if NUM_HANDLERS > 1
+	&handler2,
+#endif
+#if NUM_HANDLERS > 2
+	&handler3,
+#endif
+#if NUM_HANDLERS > 3
+	&handler4,
+#endif
+};
+
+// the panel has room for three columns, with more generators encoder D scrolls them
+// and encoders A-C follow the visible ones
+const int VISIBLE_HANDLERS = NUM_HANDLERS < GeneratorHandler::VISIBLE_COLUMNS ? NUM_HANDLERS : GeneratorHandler::VISIBLE_COLUMNS;
+int first_visible = 0;
+
+// timer driven frequency sweeps on any of the handlers
+SweepEngine sweeps;
+
+// what "W<id>" runs, set up from a host with the "=<id>B", "E", "N" and "D" fields
+struct SweepSettings {
+	long start;						// in 1/10 Hz
+	long end;
+	unsigned int steps;
+	unsigned long dwell;	// microseconds per step
+};
+
+// until set, 20 Hz to 20 kHz in 100 steps of 10 ms
+const SweepSettings default_sweep = {200L, 200000L, 100, 10000UL};
+SweepSettings sweep_settings[NUM_HANDLERS];
+
+// timer driven step sequences from PROGMEM, "Q<n>"
+Sequencer sequencer;
+
+// EEPROM presets, slot 0 brings the panel back in its last state at boot
+PresetBank presets;
+
+// loop() runs these, highest priority first, and sleeps when none is due
+TaskScheduler scheduler;
+byte task_serial, task_commit, task_display, task_presets, task_idle;
+
+#define SERIAL_PERIOD 10			// a backstop, received bytes trigger the serial task
+#define DISPLAY_PERIOD 40			// LCD flush rate limit
+#define PRESETS_PERIOD 4			// one EEPROM byte write takes 3.3 ms
+#define IDLE_CHECK_PERIOD 1000
+#define IDLE_TIMEOUT 600000UL	// ms without input before the display goes dark
+
+// generator writes wait for the commit task, so several frames in one serial drain
+// cost one write per generator; synced turns and state changes touch several generators
+// and go out as one batched update. Nothing is drawn on the event path, the display
+// task renders whatever changed once.
+byte pending_generators = 0;
+bool pending_batch = false;
+bool pending_restart = false;		// the next commit restarts every generator phase aligned
+
+// a host's "[" holds back the commit and the redraw until its "]", or BULK_TIMEOUT
+bool bulk_open = false;
+unsigned long bulk_time = 0;
+#define BULK_TIMEOUT 250
+
+#ifdef TRACE_LATENCY
+// turn to generator and LCD latencies, dumped with "T0"
+LatencyTracer tracer;
+#endif
+
+unsigned long last_activity = 0;
+bool display_asleep = false;
+
+// direct input to a generator the sequence plays ends the sequence, it would write over the input
+void release_sequence(GeneratorHandler *handler){
+	if(sequencer.active(handler))
+		sequencer.stop();
+}
 
-void handle_handler_update(GeneratorHandler * handler, int data){
+void handle_handler_update(GeneratorHandler * handler, int data, int steps, byte edit){
+	release_sequence(handler);
 	switch(data){
-		case 0:
-			// decrement
-			handler->step_frequency(-1);
-			break;
-		case 1:
-			// button press
-			handler->toggle_state(handlers, 3);
+		case EVENT_DECREMENT:
+		case EVENT_INCREMENT:
+		case EVENT_DELTA:
+			// rotation by a signed number of detents
+			handler->turn(steps, edit);
 			break;
-		case 2:
-			// increment
-			handler->step_frequency(1);
+		case EVENT_PRESS:
+			handler->toggle_state(handlers, NUM_HANDLERS);
 			break;
-		case 3:
-			// button repeat
+		case EVENT_REPEAT:
 			break;
 	}
 }
 
-void handle_handler(GeneratorHandler * handler, int data){
-	handle_handler_update(handler, data);
-	handler->show();
-	handler->update_generator();
+void handle_handler(GeneratorHandler * handler, int data, int steps){
+	PROFILE(PROFILE_HANDLE);
+	handle_handler_update(handler, data, steps, handler->_edit);
 }
 
-#define IS_BUTTON_EVENT(x) (x == 1 || x == 3)
-#define IS_ROTATE_EVENT(x) (x == 0 || x == 1)
+#define IS_BUTTON_EVENT(x) (x == EVENT_PRESS || x == EVENT_REPEAT)
+#define IS_ROTATE_EVENT(x) (x == EVENT_DECREMENT || x == EVENT_INCREMENT || x == EVENT_DELTA)
 
-void handle_handler_synced(int id, GeneratorHandler **handlers, int num_handlers, int data){
+void handle_handler_synced(int id, int data, int steps){
+	PROFILE(PROFILE_HANDLE_SYNCED);
+	byte edit = handlers[id]->_edit;
 	if(IS_BUTTON_EVENT(data)){
-		handle_handler_update(handlers[id], data);
-		for(int i = 0; i < num_handlers; i++){
-			handlers[i]->update_generator();
-		}
-		for(int i = 0; i < num_handlers; i++){
-			handlers[i]->show();
-		}
+		handle_handler_update(handlers[id], data, steps, edit);
 	} else {
-		for(int i = 0; i < num_handlers; i++){
-			handle_handler_update(handlers[i], data);
-		}
-		for(int i = 0; i < num_handlers; i++){
-			handlers[i]->update_generator();
-		}
-		for(int i = 0; i < num_handlers; i++){
-			handlers[i]->show();
-		}
+		Unroll<NUM_HANDLERS>::each([&](int i){
+			handle_handler_update(handlers[i], data, steps, edit);
+		});
+	}
+}
+
+// the states before the last press, a hold of the same button puts them back
+byte press_states[NUM_HANDLERS];
+int pressed_index = -1;
+
+void save_press(int index){
+	for(int i = 0; i < NUM_HANDLERS; i++)
+		press_states[i] = handlers[i]->_state;
+	pressed_index = index;
+}
+
+// Holding a button moves its generator on from frequency to note to phase editing and undoes
+// the state change of the press that began the hold. Going over to the phase restarts all
+// generators together, so the phase settings mean something between the outputs.
+void hold_button(int index){
+	if(index != pressed_index)
+		return;		// the hold was handled on its first repeat
+	pressed_index = -1;
+
+	for(int i = 0; i < NUM_HANDLERS; i++)
+		handlers[i]->_state = press_states[i];
+	handlers[index]->toggle_edit();
+	if(handlers[index]->_edit == GeneratorHandler::EDIT_PHASE)
+		pending_restart = true;
+	pending_batch = true;
+}
+
+// moves the panel by steps columns, generators scrolled off keep running
+void scroll_display(int steps){
+	int first = constrain(first_visible + steps, 0, NUM_HANDLERS - VISIBLE_HANDLERS);
+	if(first == first_visible)
+		return;
+	first_visible = first;
+	for(int i = 0; i < NUM_HANDLERS; i++){
+		int column = i - first_visible;
+		handlers[i]->set_column(column >= 0 && column < VISIBLE_HANDLERS ? column : GeneratorHandler::NO_COLUMN);
 	}
 }
 
-#define SERIAL_BUFFER 5
+// frames from the encoder board, read without blocking
+SerialParser parser(&Serial);
 
 typedef void (*VoidFunc)(void);
 
 void reset_device(){
+	presets.flush(handlers, NUM_HANDLERS);
 	VoidFunc p = NULL;
 	p();
 }
 
-void loop()
-{
-	// panel_leds.step(millis());
-
+void recall_preset(byte slot){
+	sequencer.stop();
 	for(int i = 0; i < NUM_HANDLERS; i++){
-		handlers[i]->show(i == NUM_HANDLERS-1);
+		sweeps.stop(handlers[i]);
 	}
+	if(presets.recall(slot, handlers, NUM_HANDLERS)){
+		presets.changed(millis());
+	}
+}
 
-	handlers[0]->show_sep();
+// one absolute setting from a host, false if out of range
+bool set_generator(GeneratorHandler *handler, int field, long value){
+	switch(field){
+		case SET_FREQUENCY:
+			sweeps.stop(handler);
+			release_sequence(handler);
+			return handler->set_frequency(value);
+		case SET_PHASE:
+			return handler->set_phase(value);
+		case SET_STEP:
+			return handler->set_step(value);
+		case SET_MODE:
+			return handler->set_mode(value);
+		case SET_STATE:
+			release_sequence(handler);
+			return handler->set_state(value);
+	}
+	return false;
+}
 
-	char buffer[SERIAL_BUFFER];
-	byte read = 0;
-	if((read = Serial.readBytesUntil('\n', buffer, SERIAL_BUFFER-1)) != 0){
-		buffer[read] = '\0';
+// one sweep parameter, checked in full when the sweep starts
+void set_sweep(SweepSettings *sweep, int field, long value){
+	switch(field){
+		case SET_SWEEP_START:
+			sweep->start = value;
+			break;
+		case SET_SWEEP_END:
+			sweep->end = value;
+			break;
+		case SET_SWEEP_STEPS:
+			sweep->steps = constrain(value, 0L, 65535L);
+			break;
+		case SET_SWEEP_DWELL:
+			sweep->dwell = value;
+			break;
+	}
+}
 
-		int id = buffer[0] - '0';
-		int data = (buffer[1] - '0');
+// id SET_ALL sets every generator, all the changes go out in one batched update
+void set_generators(int id, int field, long value){
+	if(id != SET_ALL && (id < 0 || id >= NUM_HANDLERS))
+		return;
 
-		if(id == 3){
-			reset_device();
+	if(field >= SET_SWEEP_START){
+		for(int i = 0; i < NUM_HANDLERS; i++){
+			if(id == SET_ALL || id == i)
+				set_sweep(&sweep_settings[i], field, value);
 		}
+		return;
+	}
 
-		if(id >= 0 && id < 3 && data >= 0 and data <= 3){
-			if(handlers[id]->_state == GeneratorHandler::STATE_SYNC){
-				handle_handler_synced(id, handlers, NUM_HANDLERS, data);
-			} else {
-				handle_handler(handlers[id], data);
+	bool changed = false;
+	for(int i = 0; i < NUM_HANDLERS; i++){
+		if(id == SET_ALL || id == i)
+			changed |= set_generator(handlers[i], field, value);
+	}
+	if(!changed)
+		return;
+
+	pending_batch = true;
+	scheduler.trigger(task_commit);
+	presets.changed(millis());
+}
+
+// settings arriving while a bulk is open are applied together when it closes
+void bulk_command(bool open){
+	bulk_open = open;
+	bulk_time = millis();
+	if(!open){
+		scheduler.trigger(task_commit);
+		scheduler.trigger(task_display);
+	}
+}
+
+// 0 stops, n plays built in sequence n; sweeps on the generators it plays end first
+void play_sequence(int number){
+	if(number == 0 || number > NUM_SEQUENCES){
+		sequencer.stop();
+		return;
+	}
+	for(int i = 0; i < NUM_HANDLERS; i++){
+		sweeps.stop(handlers[i]);
+	}
+	sequencer.start(&sequences[number - 1]);
+}
+
+// a sweep of one generator as last set up for it, or SWEEP_STOP to leave it where it got to;
+// a running sequence ends first, as it would hold the generator too
+void run_sweep(int id, int shape){
+	if(id < 0 || id >= NUM_HANDLERS)
+		return;
+	if(shape == SWEEP_STOP){
+		sweeps.stop(handlers[id]);
+		return;
+	}
+	sequencer.stop();
+	SweepSettings *sweep = &sweep_settings[id];
+	sweeps.start(handlers[id], sweep->start, sweep->end, sweep->steps, sweep->dwell,
+		(shape & ~SWEEP_REPEAT) == SWEEP_LOG ? SweepEngine::SHAPE_LOG : SweepEngine::SHAPE_LINEAR,
+		(shape & SWEEP_REPEAT) != 0);
+}
+
+// any input brings the display back
+void wake_display(unsigned long time){
+	last_activity = time;
+	if(!display_asleep)
+		return;
+
+	display_asleep = false;
+	panel_leds.stop();
+	panel_leds.deactivate_leds();
+	lcd.display();
+	lcd.backlight();
+}
+
+// the display goes dark and the panel LEDs animate from the timer tick until the next input
+void sleep_display(unsigned long time){
+	display_asleep = true;
+	lcd.noDisplay();
+	lcd.noBacklight();
+	panel_leds.begin(time, LEDHandler::STYLE_RANDOM, DEFAULT_PANEL_LEDS_SHOW_TIME, DEFAULT_PANEL_LEDS_BLANK_TIME);
+}
+
+void handle_command(int id, int data, int steps){
+	switch(data){
+		case EVENT_LATENCY:
+#ifdef TRACE_LATENCY
+			tracer.encoder_latency(id, steps);
+#endif
+			return;
+		case EVENT_TRACE:
+#ifdef TRACE_LATENCY
+			if(id == 0)
+				tracer.dump(&Serial);
+			if(id == 1)
+				tracer.reset();
+#endif
+#ifdef PROFILE_SECTIONS
+			if(id == 2){
+				profiler_dump(&Serial);
+				profiler_reset();
 			}
+#endif
+			return;
+	}
+
+	wake_display(millis());
+
+	switch(data){
+		case EVENT_RECALL:
+			recall_preset(id);
+			return;
+		case EVENT_STORE:
+			presets.store(id);
+			return;
+		case EVENT_SET:
+			set_generators(id, steps, parser.value());
+			return;
+		case EVENT_BULK:
+			bulk_command(id != 0);
+			return;
+		case EVENT_SEQUENCE:
+			play_sequence(id);
+			return;
+		case EVENT_SWEEP:
+			run_sweep(id, steps);
+			return;
+	}
+
+	// encoder D's button resets, a turn of it scrolls the panel
+	if(id == 3 && data == EVENT_PRESS){
+		reset_device();
+	}
+	if(id == 3 && IS_ROTATE_EVENT(data)){
+		scroll_display(steps);
+		return;
+	}
+
+	// encoders A-C work the generators in view
+	int index = first_visible + id;
+	if(id >= 0 && id < VISIBLE_HANDLERS && data >= 0 and data <= EVENT_DELTA){
+		if(data == EVENT_PRESS)
+			save_press(index);
+
+		if(data == EVENT_REPEAT){
+			hold_button(index);
+		} else if(handlers[index]->_state == GeneratorHandler::STATE_SYNC){
+			handle_handler_synced(index, data, steps);
+			pending_batch = true;
+		} else {
+			handle_handler(handlers[index], data, steps);
+			if(data == EVENT_PRESS)
+				pending_batch = true;
+			else
+				pending_generators |= 1 << index;
 		}
+		scheduler.trigger(task_commit);
+		presets.changed(millis());
+	}
+}
+
+void serial_task(unsigned long time){
+	int id, data, steps;
+	{
+		PROFILE(PROFILE_SERIAL_READ);
+		parser.receive();
 	}
+	while(parser.next_command(id, data, steps)){
+#ifdef TRACE_LATENCY
+		if(IS_ROTATE_EVENT(data) && parser.last_sequence() >= 0)
+			tracer.parsed(parser.last_sequence(), parser.received_time(), micros());
+#endif
+		handle_command(id, data, steps);
+	}
+	if(bulk_open && time - bulk_time >= BULK_TIMEOUT)
+		bulk_command(false);
+}
+
+void commit_task(unsigned long time){
+	if(bulk_open)
+		return;
+
+	if(pending_restart){
+		GeneratorHandler::restart_generators(handlers, NUM_HANDLERS);
+	} else if(pending_batch){
+		GeneratorHandler::update_generators(handlers, NUM_HANDLERS);
+	} else {
+		Unroll<NUM_HANDLERS>::each([](int i){
+			if(pending_generators & (1 << i))
+				handlers[i]->update_generator();
+		});
+	}
+	pending_generators = 0;
+	pending_batch = false;
+	pending_restart = false;
+#ifdef TRACE_LATENCY
+	tracer.committed(micros());
+#endif
+}
+
+// sweeps are still followed while the display is dark
+void display_task(unsigned long time){
+	sweeps.refresh(time);
+	sequencer.refresh(time);
+	if(display_asleep || bulk_open)
+		return;
+
+	// every LED, scrolled off generators keep theirs up to date too
+	Unroll<NUM_HANDLERS>::each([](int i){
+		handlers[i]->show_led_per_state();
+	});
+	Unroll<VISIBLE_HANDLERS>::each([](int i){
+		PROFILE(PROFILE_SHOW + i);
+		handlers[first_visible + i]->show();
+	});
+
+	{
+		PROFILE(PROFILE_SHOW_SEP);
+		handlers[0]->show_sep();
+	}
+	{
+		PROFILE(PROFILE_LCD_FLUSH);
+		display.flush();
+	}
+#ifdef TRACE_LATENCY
+	tracer.flushed(micros());
+#endif
+}
+
+void presets_task(unsigned long time){
+	presets.service(time, handlers, NUM_HANDLERS);
+}
+
+void idle_task(unsigned long time){
+	if(!display_asleep && time - last_activity >= IDLE_TIMEOUT)
+		sleep_display(time);
+}
+
+void setup_tasks(){
+	task_serial = scheduler.add(serial_task, SERIAL_PERIOD);
+	task_commit = scheduler.add(commit_task, 0);
+	task_display = scheduler.add(display_task, DISPLAY_PERIOD);
+	task_presets = scheduler.add(presets_task, PRESETS_PERIOD);
+	task_idle = scheduler.add(idle_task, IDLE_CHECK_PERIOD);
+	last_activity = millis();
+}
+
+void loop()
+{
+	if(Serial.available())
+		scheduler.trigger(task_serial);
+
+	if(!scheduler.run(millis()))
+		scheduler.idle();
 }
 
 void setup_leds(){
 	for(int i = 0; i < NUM_PANEL_LEDS; i++){
-		pinMode(led_pins[i], OUTPUT);
-		digitalWrite(led_pins[i], LOW);
+		int pin = progmem_read(&led_pins[i]);
+		pinMode(pin, OUTPUT);
+		digitalWrite(pin, LOW);
 	}
+	panel_leds.attach_timer();
 	// unsigned long time = millis();
 	// panel_leds.begin(time, LEDHandler::STYLE_RANDOM, DEFAULT_PANEL_LEDS_SHOW_TIME, DEFAULT_PANEL_LEDS_BLANK_TIME);
 }
@@ -157,6 +580,10 @@ void setup()
 	// Serial.setTimeout(100);
 
 	setup_leds();
+	sweeps.begin();
+	for(int i = 0; i < NUM_HANDLERS; i++)
+		sweep_settings[i] = default_sweep;
+	sequencer.begin(handlers, NUM_HANDLERS);
 
 	int status;
 
@@ -173,20 +600,18 @@ void setup()
 	// Print a message to the LCD
 	// lcd.print("Hello, World!");
 
-	uint8_t line_sep[8] = {0x04,0x04,0x04,0x04,0x04,0x04,0x04,0x04};
-	uint8_t dots_sep[8] = {0x04,0x00,0x04,0x00,0x04,0x00,0x04,0x00};
-	uint8_t far_dots_sep[8] = {0x04,0x00,0x00,0x00,0x04,0x00,0x00,0x00};
-	// uint8_t far_far_dots_sep[8] = {0x00,0x00,0x00,0x00,0x04,0x00,0x00,0x00};
+	uint8_t bitmap[8];
+	for(int i = 0; i < NUM_SEPARATOR_CHARS; i++){
+		progmem_copy(bitmap, separator_chars[i]);
+		lcd.createChar(i + 1, bitmap);
+	}
 
-	// vertical brackets
-	// uint8_t top_sep[8] = {0x0e,0x04,0x04,0x04,0x04,0x04,0x04,0x04};
-	// uint8_t mid_sep[8] = {0x04,0x04,0x04,0x04,0x04,0x04,0x04,0x04};
-	// uint8_t bot_sep[8] = {0x04,0x04,0x04,0x04,0x04,0x04,0x04,0x0e};
-
-	lcd.createChar(1, line_sep);
-	lcd.createChar(2, dots_sep);
-	lcd.createChar(3, far_dots_sep);
-	// lcd.createChar(4, far_far_dots_sep);
+	// bring all generators back to their last state in one batched update,
+	// the first pass of loop() draws it
+	presets.begin();
+	presets.recall(PresetBank::LAST_STATE, handlers, NUM_HANDLERS);
+
+	setup_tasks();
 
 	// AD1.begin();
 	// AD1.setMode(MD_AD9833::MODE_SINE);
@@ -0,0 +1,170 @@
+#include <SPI.h>
+#include "ad9833_driver.h"
+
+AD9833Driver::AD9833Driver(uint8_t fsync_pin){
+	_fsync_pin = fsync_pin;
+	_control = AD9833_B28;
+	_frequency[0] = _frequency[1] = 0;
+	_phase[0] = _phase[1] = 0;
+	_active = 0;
+	_staged = false;
+	_next_control = _control;
+	_issued = 0;
+	_suppressed = 0;
+
+	pinMode(_fsync_pin, OUTPUT);
+	digitalWrite(_fsync_pin, HIGH);
+}
+
+// datasheet initialisation: hold in reset, clear both register sets, release in the given mode
+// the registers are written unconditionally here, this is what makes the shadow valid
+void AD9833Driver::begin(byte mode){
+	SPI.begin();
+
+	write(AD9833_B28 | AD9833_RESET);
+	for(byte reg = 0; reg < 2; reg++){
+		uint16_t address = reg ? AD9833_FREQ1 : AD9833_FREQ0;
+		write(address);
+		write(address);
+		write(reg ? AD9833_PHASE1 : AD9833_PHASE0);
+		_frequency[reg] = 0;
+		_phase[reg] = 0;
+	}
+	_active = 0;
+	_control = AD9833_B28 | mode_bits(mode);
+	write(_control);
+}
+
+void AD9833Driver::set_mode(byte mode){
+	uint16_t control = AD9833_B28 | mode_bits(mode) | (_active ? AD9833_SELECT : 0);
+	if(control == _control){
+		_suppressed++;
+		return;
+	}
+	_control = control;
+	write(_control);
+}
+
+// with B28 set the two 14 bit halves go out back to back, LSBs first
+void AD9833Driver::set_frequency(byte reg, uint32_t tuning_word){
+	if(tuning_word == _frequency[reg]){
+		_suppressed += 2;
+		return;
+	}
+	_frequency[reg] = tuning_word;
+
+	uint16_t address = reg ? AD9833_FREQ1 : AD9833_FREQ0;
+	write(address | (uint16_t)(tuning_word & 0x3fff));
+	write(address | (uint16_t)((tuning_word >> 14) & 0x3fff));
+}
+
+void AD9833Driver::set_phase(byte reg, uint16_t phase_word){
+	phase_word &= 0x0fff;
+	if(phase_word == _phase[reg]){
+		_suppressed++;
+		return;
+	}
+	_phase[reg] = phase_word;
+	write((reg ? AD9833_PHASE1 : AD9833_PHASE0) | phase_word);
+}
+
+void AD9833Driver::write(uint16_t word){
+	SPI.beginTransaction(SPISettings(AD9833_SPI_CLOCK, MSBFIRST, SPI_MODE2));
+	digitalWrite(_fsync_pin, LOW);
+	SPI.transfer16(word);
+	digitalWrite(_fsync_pin, HIGH);
+	SPI.endTransaction();
+	_issued++;
+}
+
+byte AD9833Driver::active(){
+	return _active;
+}
+
+// loads the register set the output is not running from, nothing changes until commit()
+// switches over to it in mode
+void AD9833Driver::stage(uint32_t tuning_word, uint16_t phase_word, byte mode){
+	set_frequency(!_active, tuning_word);
+	set_phase(!_active, phase_word);
+	_next_control = AD9833_B28 | mode_bits(mode) | (_active ? 0 : AD9833_SELECT);
+	_staged = true;
+}
+
+// words each chip has been sent, and writes dropped because the register already held the value
+unsigned long AD9833Driver::words_issued(){
+	return _issued;
+}
+
+unsigned long AD9833Driver::words_suppressed(){
+	return _suppressed;
+}
+
+void AD9833Driver::reset_counts(){
+	_issued = 0;
+	_suppressed = 0;
+}
+
+// Switches every staged chip over to its other register set.
+void AD9833Driver::commit(AD9833Driver **drivers, byte count){
+	latch(drivers, count);
+}
+
+// Stops the output and clears the phase accumulator, release() starts them again.
+// The registers can be loaded meanwhile, the output sits at midscale.
+// release() lets it go in mode.
+void AD9833Driver::hold(byte mode){
+	_control = AD9833_B28 | mode_bits(mode) | (_active ? AD9833_SELECT : 0);
+	write(_control | AD9833_RESET);
+}
+
+// Lets every held chip run again from a zero phase accumulator, all on the same SCLK edge
+void AD9833Driver::release(AD9833Driver **drivers, byte count){
+	for(byte i = 0; i < count; i++){
+		drivers[i]->_next_control = drivers[i]->_control;
+		drivers[i]->_staged = true;
+	}
+	latch(drivers, count);
+}
+
+// Sends each staged chip its next control word.
+// DATA and CLK are shared, so with all of their FSYNCs held low the chips latch the same
+// control word on the same SCLK edge. Chips needing a different control word, e.g. in
+// another mode, take it on a further word.
+void AD9833Driver::latch(AD9833Driver **drivers, byte count){
+	for(byte i = 0; i < count; i++){
+		if(!drivers[i]->_staged)
+			continue;
+
+		uint16_t control = drivers[i]->_next_control;
+		SPI.beginTransaction(SPISettings(AD9833_SPI_CLOCK, MSBFIRST, SPI_MODE2));
+		for(byte j = i; j < count; j++){
+			if(drivers[j]->_staged && drivers[j]->_next_control == control)
+				digitalWrite(drivers[j]->_fsync_pin, LOW);
+		}
+		SPI.transfer16(control);
+		for(byte j = i; j < count; j++){
+			if(drivers[j]->_staged && drivers[j]->_next_control == control){
+				digitalWrite(drivers[j]->_fsync_pin, HIGH);
+				drivers[j]->_control = control;
+				drivers[j]->_active = (control & AD9833_FSELECT) ? 1 : 0;
+				drivers[j]->_staged = false;
+				drivers[j]->_issued++;
+			}
+		}
+		SPI.endTransaction();
+	}
+}
+
+uint16_t AD9833Driver::mode_bits(byte mode){
+	switch(mode){
+		case MODE_OFF:
+			return AD9833_SLEEP1 | AD9833_SLEEP12;
+		case MODE_SQUARE1:
+			return AD9833_OPBITEN | AD9833_DIV2;
+		case MODE_SQUARE2:
+			return AD9833_OPBITEN;
+		case MODE_TRIANGLE:
+			return AD9833_MODE;
+	}
+	return 0;
+}
@@ -0,0 +1,79 @@
+#include "fixed_point.h"
+#include "progmem.h"
+
+#define MAX_DIGITS 10
+
+const unsigned long powers_of_ten[MAX_DIGITS - 1] PROGMEM = {
+	1000000000UL, 100000000UL, 10000000UL, 1000000UL, 100000UL, 10000UL, 1000UL, 100UL, 10UL
+};
+
+// most significant first, no leading zeros, returns the count
+static byte to_digits(unsigned long value, char *digits){
+	byte count = 0;
+	for(byte i = 0; i < MAX_DIGITS - 1; i++){
+		unsigned long power = progmem_read(&powers_of_ten[i]);
+		char digit = '0';
+		while(value >= power){
+			value -= power;
+			digit++;
+		}
+		if(digit != '0' || count != 0)
+			digits[count++] = digit;
+	}
+	digits[count++] = '0' + value;
+	return count;
+}
+
+void format_fixed_point(long value, char *field, byte width){
+	char text[MAX_DIGITS + 3];
+	char digits[MAX_DIGITS];
+	byte length = 0;
+
+	unsigned long magnitude = value;
+	if(value < 0){
+		text[length++] = '-';
+		magnitude = -magnitude;
+	}
+
+	byte count = to_digits(magnitude, digits);
+	if(count == 1)
+		text[length++] = '0';
+	for(byte i = 0; i < count - 1; i++)
+		text[length++] = digits[i];
+	text[length++] = '.';
+	text[length++] = digits[count - 1];
+
+	if(length > width)
+		length = width;
+	byte pad = width - length;
+	memset(field, ' ', pad);
+	memcpy(field + pad, text, length);
+	field[width] = '\0';
+}
+
+FixedPointField::FixedPointField(){
+	_value = 0;
+	_valid = false;
+}
+
+// false when the field already shows value
+bool FixedPointField::render(long value, char *field, byte width){
+	if(!changed(value))
+		return false;
+	format_fixed_point(value, field, width);
+	return true;
+}
+
+// remembers value, false when the field already shows it
+bool FixedPointField::changed(long value){
+	if(_valid && value == _value)
+		return false;
+	_value = value;
+	_valid = true;
+	return true;
+}
+
+// the next render() formats whatever the value
+void FixedPointField::invalidate(){
+	_valid = false;
+}
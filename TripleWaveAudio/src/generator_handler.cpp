@@ -1,13 +1,33 @@
 #include <Wire.h>
 #include <hd44780.h>											 // main hd44780 header
 #include <hd44780ioClass/hd44780_I2Cexp.h> // i2c expander i/o class header
-#include <MD_AD9833.h>
+#include "ad9833_driver.h"
 #include "led_handler.h"
+#include "lcd_buffer.h"
 #include "generator_handler.h"
+#include "fixed_point.h"
+#include "notes.h"
+#include "profiler.h"
+#include "progmem.h"
 
 #define DEFAULT_SILENT_FREQ 0L
 
-GeneratorHandler::GeneratorHandler(hd44780_I2Cexp *lcd, MD_AD9833 *generator, LEDHandler *handler, byte id, long frequency, byte step, int phase, MD_AD9833::mode_t mode, byte state){
+// frequency step per _step setting, in 1/10 Hz
+const long step_frequencies[GeneratorHandler::MAX_STEP + 1] PROGMEM = {1L, 10L, 100L, 1000L, 10000L};
+
+// fastest first, turns slower than the last entry step 1x
+#define NUM_ACCELERATION_STEPS 3
+const AccelerationStep frequency_acceleration[NUM_ACCELERATION_STEPS] PROGMEM = {
+	{8, 16},
+	{20, 6},
+	{40, 2}
+};
+
+// indexed by state
+#define STATE_LABEL_SIZE 5
+const char state_labels[4][STATE_LABEL_SIZE] PROGMEM = {"Norm", "Mute", "Sync", "Solo"};
+
+GeneratorHandler::GeneratorHandler(LCDBuffer *lcd, AD9833Driver *generator, LEDHandler *handler, byte id, long frequency, byte step, int phase, byte mode, byte state){
 	_lcd = lcd;
 	_generator = generator;
 	_handler = handler;
@@ -17,19 +37,27 @@ GeneratorHandler::GeneratorHandler(hd44780_I2Cexp *lcd, MD_AD9833 *generator, LE
 	_phase = phase;
 	_mode = mode;
 	_state = state;
+	_edit = EDIT_FREQUENCY;
 	_silent_freq = DEFAULT_SILENT_FREQ;
+	_note = NO_NOTE;
+	_last_turn_time = 0;
+	_last_direction = 0;
+	_sweeping = false;
+	_column = _id < VISIBLE_COLUMNS ? _id : NO_COLUMN;
 
-	_generator->begin();
-	_generator->setMode(_mode);
-	_generator->setFrequency((MD_AD9833::channel_t)0, _silent_freq);
+	_generator->begin(_mode);
+	_generator->set_frequency(0, AD9833Driver::tuning_word(_silent_freq));
+	_last_set_freq = _silent_freq;
+	_last_set_phase = 0;
+	_last_set_mode = _mode;
 }
 
 void GeneratorHandler::silence(){
-	_generator->setFrequency((MD_AD9833::channel_t)0, _silent_freq);
+	_generator->set_frequency(_generator->active(), AD9833Driver::tuning_word(_silent_freq));
 }
 
 void GeneratorHandler::step_frequency(int steps){
-	int increment = step_to_frequency();
+	long increment = step_to_frequency();
 	_frequency += increment * steps;
 	if(_frequency < 0)
 		_frequency = 0;
@@ -38,6 +66,19 @@ void GeneratorHandler::step_frequency(int steps){
 
 }
 
+// semitones from the note the frequency is on, from the note just past it otherwise,
+// so the first step off a frequency between notes goes to the neighbouring one
+void GeneratorHandler::step_note(int steps){
+	int note = current_note();
+	if(note == NO_NOTE){
+		note = note_at_or_below(_frequency);
+		if(steps < 0 && (note == NO_NOTE || note_to_frequency(note) != _frequency))
+			note++;
+	}
+	_note = constrain(note + steps, 0, NUM_NOTES - 1);
+	_frequency = note_to_frequency(_note);
+}
+
 void GeneratorHandler::step_phase(int steps){
 	_phase += steps;
 	while(_phase < 0)
@@ -54,14 +95,51 @@ void GeneratorHandler::step_step(int steps){
 		_step -= MAX_STEP;
 }
 
+// a turn of the encoder, edit is the target of whichever handler was turned;
+// only frequency edits speed up with the rate of turning, notes and phase step as turned
+void GeneratorHandler::turn(int steps, byte edit){
+	if(edit == EDIT_PHASE)
+		step_phase(steps * PHASE_STEP);
+	else if(edit == EDIT_NOTE)
+		step_note(steps);
+	else
+		step_frequency(accelerate(steps, millis()));
+}
+
+// scales a turn by the time per detent since the last one, a change of direction starts over at 1x
+// the encoder board sends several detents in one frame, so the interval is compared per detent
+int GeneratorHandler::accelerate(int steps, unsigned long time){
+	unsigned long interval = time - _last_turn_time;
+	int direction = steps < 0 ? -1 : 1;
+	_last_turn_time = time;
+
+	byte multiplier = 1;
+	if(direction == _last_direction){
+		unsigned int detents = abs(steps);
+		for(byte i = 0; i < NUM_ACCELERATION_STEPS; i++){
+			AccelerationStep step = progmem_read(&frequency_acceleration[i]);
+			if(interval < (unsigned long)step.interval * detents){
+				multiplier = step.multiplier;
+				break;
+			}
+		}
+	}
+	_last_direction = direction;
+	return steps * multiplier;
+}
+
+// steps the encoder from frequency to note to phase and back, the step row shows which
+void GeneratorHandler::toggle_edit(){
+	_edit = _edit == EDIT_PHASE ? EDIT_FREQUENCY : _edit + 1;
+	_step_field.invalidate();
+}
+
 void GeneratorHandler::switch_to_normal(byte old_state, GeneratorHandler **handlers, int num_handlers){
 	_state = STATE_NORMAL;
 	if(old_state == STATE_SYNC){
 		for(int i = 0; i < num_handlers; i++){
 			if(_id != handlers[i]->_id){
 				handlers[i]->_state = GeneratorHandler::STATE_NORMAL;
-				handlers[i]->update_generator();
-				handlers[i]->show();
 			}
 		}
 	}
@@ -73,8 +151,6 @@ void GeneratorHandler::switch_to_muted(byte old_state, GeneratorHandler **handle
 		for(int i = 0; i < num_handlers; i++){
 			if(_id != handlers[i]->_id){
 				handlers[i]->_state = GeneratorHandler::STATE_MUTED;
-				handlers[i]->update_generator();
-				handlers[i]->show();
 			}
 		}
 	}
@@ -85,8 +161,6 @@ void GeneratorHandler::switch_to_solo(byte old_state, GeneratorHandler **handler
 	for(int i = 0; i < num_handlers; i++){
 		if(_id != handlers[i]->_id){
 			handlers[i]->_state = GeneratorHandler::STATE_MUTED;
-			handlers[i]->update_generator();
-			handlers[i]->show();
 		}
 	}
 }
@@ -96,12 +170,12 @@ void GeneratorHandler::switch_to_sync(byte old_state, GeneratorHandler **handler
 	for(int i = 0; i < num_handlers; i++){
 		if(_id != handlers[i]->_id){
 			handlers[i]->_state = GeneratorHandler::STATE_SYNC;
-			handlers[i]->update_generator();
-			handlers[i]->show();
 		}
 	}
 }
 
+// Only works out the next state of every handler, the caller then brings the generators
+// over in one update_generators() and the display task draws the result once
 void GeneratorHandler::toggle_state(GeneratorHandler **handlers, int num_handlers){
 	byte old_state = _state;
 	switch(_state){
@@ -120,44 +194,170 @@ void GeneratorHandler::toggle_state(GeneratorHandler **handlers, int num_handler
 	}
 }
 
+void GeneratorHandler::save_settings(GeneratorSettings *settings){
+	settings->frequency = _frequency;
+	settings->phase = _phase;
+	settings->step = _step;
+	settings->mode = _mode;
+	settings->state = _state;
+}
+
+// takes effect on the next update_generator(s), returns false and changes nothing if out of range
+bool GeneratorHandler::load_settings(const GeneratorSettings *settings){
+	if(settings->frequency < 0 || settings->frequency > MAX_FREQUENCY ||
+		settings->phase < 0 || settings->phase > MAX_PHASE ||
+		settings->step > MAX_STEP || settings->mode > AD9833Driver::MODE_TRIANGLE || settings->state > STATE_SOLO)
+		return false;
+
+	_frequency = settings->frequency;
+	_phase = settings->phase;
+	_step = settings->step;
+	_state = settings->state;
+	_mode = settings->mode;
+	return true;
+}
+
+// absolute settings from a host, each takes effect on the next update_generator(s) and
+// returns false and changes nothing if out of range
+bool GeneratorHandler::set_frequency(long frequency){
+	if(frequency < 0 || frequency > MAX_FREQUENCY)
+		return false;
+	_frequency = frequency;
+	return true;
+}
+
+bool GeneratorHandler::set_phase(long phase){
+	if(phase < 0 || phase > MAX_PHASE)
+		return false;
+	_phase = phase;
+	return true;
+}
+
+bool GeneratorHandler::set_step(long step){
+	if(step < 0 || step > MAX_STEP)
+		return false;
+	_step = step;
+	return true;
+}
+
+bool GeneratorHandler::set_mode(long mode){
+	if(mode < 0 || mode > AD9833Driver::MODE_TRIANGLE)
+		return false;
+	_mode = mode;
+	return true;
+}
+
+bool GeneratorHandler::set_state(long state){
+	if(state < 0 || state > STATE_SOLO)
+		return false;
+	_state = state;
+	return true;
+}
+
 void GeneratorHandler::update_generator(){
+	PROFILE(PROFILE_UPDATE_GENERATOR);
+	update_mode();
+	if(_sweeping)
+		return;
+
 	switch(_state){
 		case STATE_NORMAL:
 		case STATE_SYNC:
 		case STATE_SOLO:
 			if(_frequency != _last_set_freq){
-				_generator->setFrequency((MD_AD9833::channel_t)0, _frequency / 10.0);
+				_generator->set_frequency(_generator->active(), frequency_word());
 				_last_set_freq = _frequency;
 			}
 			if(_phase != _last_set_phase){
-				_generator->setPhase((MD_AD9833::channel_t)0, _phase);
+				_generator->set_phase(_generator->active(), AD9833Driver::phase_word(_phase));
 				_last_set_phase = _phase;
 			}
 		break;
 		case STATE_MUTED:
-			_generator->setFrequency((MD_AD9833::channel_t)0, _silent_freq);
-			_last_set_freq = _silent_freq;
+			if(_last_set_freq != _silent_freq){
+				_generator->set_frequency(_generator->active(), AD9833Driver::tuning_word(_silent_freq));
+				_last_set_freq = _silent_freq;
+			}
 			break;
 	}
 }
 
-void GeneratorHandler::decimalize(long value, char *buffer){
-	long main = value / 10L;
-	int dec = value % 10L;
-	sprintf(buffer, "%ld.%d", main, dec);
-}
+// Updates several generators so their outputs change together: each changed chip gets
+// its new words loaded into the idle register set, then all switch over on one SPI word
+void GeneratorHandler::update_generators(GeneratorHandler **handlers, int num_handlers){
+	AD9833Driver *staged[MAX_HANDLERS];
+	byte count = 0;
 
-void GeneratorHandler::show_right_aligned(byte col, byte row, const char *buffer, byte max_width){
-	byte width = strlen(buffer);
-	if(width <= max_width){
-		byte diff = max_width - width;
-		for(byte i = 0; i < diff; i++){
-		_lcd->setCursor(col++, row);
-		_lcd->write(' ');
+	for(int i = 0; i < num_handlers && i < MAX_HANDLERS; i++){
+		GeneratorHandler *handler = handlers[i];
+		if(handler->_sweeping){
+			handler->update_mode();
+			continue;
+		}
+		bool muted = handler->_state == STATE_MUTED;
+		long frequency = muted ? handler->_silent_freq : handler->_frequency;
+		if(frequency != handler->_last_set_freq || handler->_phase != handler->_last_set_phase ||
+			handler->_mode != handler->_last_set_mode){
+			uint32_t word = muted ? AD9833Driver::tuning_word(frequency) : handler->frequency_word();
+			handler->_generator->stage(word, AD9833Driver::phase_word(handler->_phase), handler->_mode);
+			handler->_last_set_freq = frequency;
+			handler->_last_set_phase = handler->_phase;
+			handler->_last_set_mode = handler->_mode;
+			staged[count++] = handler->_generator;
 		}
 	}
-	_lcd->setCursor(col, row);
-	_lcd->write(buffer);
+
+	AD9833Driver::commit(staged, count);
+}
+
+// Restarts the generators together so their phase settings line up: all are held in reset
+// with their phase accumulators cleared, loaded, then released on one SPI word.
+// Running chips keep that alignment while their frequencies are equal; a muted generator
+// stops at 0 Hz, so it needs another restart once it plays again.
+void GeneratorHandler::restart_generators(GeneratorHandler **handlers, int num_handlers){
+	AD9833Driver *held[MAX_HANDLERS];
+	byte count = 0;
+
+	for(int i = 0; i < num_handlers && i < MAX_HANDLERS; i++){
+		GeneratorHandler *handler = handlers[i];
+		if(handler->_sweeping)
+			continue;
+		bool muted = handler->_state == STATE_MUTED;
+		long frequency = muted ? handler->_silent_freq : handler->_frequency;
+		AD9833Driver *generator = handler->_generator;
+		generator->hold(handler->_mode);
+		generator->set_frequency(generator->active(), muted ? AD9833Driver::tuning_word(frequency) : handler->frequency_word());
+		generator->set_phase(generator->active(), AD9833Driver::phase_word(handler->_phase));
+		handler->_last_set_freq = frequency;
+		handler->_last_set_phase = handler->_phase;
+		handler->_last_set_mode = handler->_mode;
+		held[count++] = generator;
+	}
+
+	AD9833Driver::release(held, count);
+}
+
+// the mode goes out on its own control word, a sweep or the sequencer leave it alone
+void GeneratorHandler::update_mode(){
+	if(_mode != _last_set_mode){
+		_generator->set_mode(_mode);
+		_last_set_mode = _mode;
+	}
+}
+
+// the note last stepped to, NO_NOTE once anything else has moved the frequency
+int GeneratorHandler::current_note(){
+	if(_note != NO_NOTE && note_to_frequency(_note) != _frequency)
+		_note = NO_NOTE;
+	_last_turn_time = 0;
+	_last_direction = 0;
+	return _note;
+}
+
+// the word for _frequency, read from the note table while on a note
+uint32_t GeneratorHandler::frequency_word(){
+	int note = current_note();
+	return note != NO_NOTE ? note_to_word(note) : AD9833Driver::tuning_word(_frequency);
 }
 
 void GeneratorHandler::show_centered(byte col, byte row, const char *buffer, byte max_width){
@@ -169,81 +369,87 @@ void GeneratorHandler::show_centered(byte col, byte row, const char *buffer, byt
 	_lcd->write(buffer);
 }
 
-// long represents a value in 1/10ths
-void GeneratorHandler::show_fixed_point_long(long value, byte col, byte row, char *buffer, byte max_width){
-	decimalize(value, buffer);
-	show_right_aligned(col, row, buffer, max_width);
+// long represents a value in 1/10ths, false when the field already shows it
+bool GeneratorHandler::show_fixed_point_long(FixedPointField *field, long value, byte col, byte row, char *buffer, byte max_width){
+	if(!field->render(value, buffer, max_width))
+		return false;
+	_lcd->setCursor(col, row);
+	_lcd->write(buffer);
+	return true;
 }
 
 void GeneratorHandler::show_frequency(byte col, byte row, char *buffer, byte max_width){
-	show_fixed_point_long(_frequency, col, row, buffer, max_width);
+	show_fixed_point_long(&_frequency_field, _frequency, col, row, buffer, max_width);
 }
 
 // returns a step number from 0 to 4 into a step frequency in 1/10th Hz multiples 1 10 100 1000 10000
 long GeneratorHandler::step_to_frequency(){
-	switch(_step){
-		case 0:
-		return 1L;
-		case 1:
+	if(_step > MAX_STEP)
 		return 10L;
-		case 2:
-		return 100L;
-		case 3:
-		return 1000L;
-		case 4:
-		return 10000L;
-	}
-	return 10L;
+	return progmem_read(&step_frequencies[_step]);
 }
 
+// the step of whatever the encoder edits, in degrees while editing the phase
+// and the note while stepping by semitone
 void GeneratorHandler::show_step(byte col, byte row, char *buffer, byte max_width){
+	if(_edit == EDIT_NOTE){
+		show_note(col, row, buffer, max_width);
+		return;
+	}
+	if(_edit == EDIT_PHASE){
+		if(show_fixed_point_long(&_step_field, PHASE_STEP, col, row, buffer, max_width-1))
+			_lcd->write(223);
+		return;
+	}
 	long frequency = step_to_frequency();
-	show_fixed_point_long(frequency, col, row, buffer, max_width);
+	show_fixed_point_long(&_step_field, frequency, col, row, buffer, max_width);
+}
+
+// the nearest note, marked when the frequency is off it; the field keeps the note
+// and whether it was exact, so the name is drawn again only when either changes
+void GeneratorHandler::show_note(byte col, byte row, char *buffer, byte max_width){
+	int note = current_note();
+	if(note == NO_NOTE)
+		note = nearest_note(_frequency);
+	bool exact = note_to_frequency(note) == _frequency;
+	if(!_step_field.changed(exact ? note : note + NUM_NOTES))
+		return;
+	format_note(note, exact, buffer, max_width);
+	_lcd->setCursor(col, row);
+	_lcd->write(buffer);
 }
 
 void GeneratorHandler::show_phase(byte col, byte row, char *buffer, byte max_width){
-	show_fixed_point_long(_phase, col, row, buffer, max_width-1);
-	_lcd->write(223);
+	if(show_fixed_point_long(&_phase_field, _phase, col, row, buffer, max_width-1))
+		_lcd->write(223);
 }
 
 void GeneratorHandler::show_state(byte col, byte row, byte max_width){
-	switch(_state){
-		case STATE_NORMAL:
-			show_centered(col, row, "Norm", max_width);
-			break;
-		case STATE_MUTED:
-			show_centered(col, row, "Mute", max_width);
-			break;
-		case STATE_SYNC:
-			show_centered(col, row, "Sync", max_width);
-			break;
-		case STATE_SOLO:
-			show_centered(col, row, "Solo", max_width);
-			break;
-	}
+	if(_state > STATE_SOLO)
+		return;
+	char label[STATE_LABEL_SIZE];
+	progmem_copy(label, state_labels[_state]);
+	show_centered(col, row, label, max_width);
 }
 
-// 0=top, 1=middle, 2=bottom
+// 0=top, 1=middle, 2=bottom, the state row repeats the bottom
 void GeneratorHandler::show_sep(){
-	_lcd->setCursor(6, 0);
-	_lcd->write(1);
-	_lcd->setCursor(13, 0);
-	_lcd->write(1);
-	_lcd->setCursor(6, 1);
-	_lcd->write(2);
-	_lcd->setCursor(13, 1);
-	_lcd->write(2);
-	_lcd->setCursor(6, 2);
-	_lcd->write(3);
-	_lcd->setCursor(13, 2);
-	_lcd->write(3);
-	_lcd->setCursor(6, 4);
-	_lcd->write(3);
-	_lcd->setCursor(13, 4);
-	_lcd->write(3);
+	for(byte col = HANDLER_WIDTH - 1; col < LCDBuffer::COLS; col += HANDLER_WIDTH){
+		_lcd->setCursor(col, 0);
+		_lcd->write(1);
+		_lcd->setCursor(col, 1);
+		_lcd->write(2);
+		_lcd->setCursor(col, 2);
+		_lcd->write(3);
+		_lcd->setCursor(col, 3);
+		_lcd->write(3);
+	}
 }
 
+// generators past the panel LEDs have none to show
 void GeneratorHandler::show_led_per_state(){
+	if(_id >= _handler->num_leds())
+		return;
 	switch(_state){
 		case STATE_NORMAL:
 			_handler->activate_led(_id);
@@ -260,14 +466,28 @@ void GeneratorHandler::show_led_per_state(){
 	}
 }
 
-void GeneratorHandler::show(bool last_handler){
-	char buffer[10];
-	byte col = (_id) * HANDLER_WIDTH;
+// moves the handler to another column of the panel, its fields are drawn afresh there
+void GeneratorHandler::set_column(int column){
+	if(column == _column)
+		return;
+	_column = column;
+	_frequency_field.invalidate();
+	_step_field.invalidate();
+	_phase_field.invalidate();
+}
+
+// the fields, nothing while scrolled off the panel; the LED is shown separately,
+// as it follows the state whether the generator is in view or not
+void GeneratorHandler::show(){
+	if(_column == NO_COLUMN)
+		return;
+
+	char buffer[FixedPointField::MAX_WIDTH + 1];
+	byte col = _column * HANDLER_WIDTH;
 	byte max_width = HANDLER_WIDTH-1;
 
 	show_frequency(col, 0, buffer, max_width);
 	show_step(col, 1, buffer, max_width);
 	show_phase(col, 2, buffer, max_width);
 	show_state(col, 3, max_width);
-	show_led_per_state();
 }
@@ -0,0 +1,126 @@
+#include "latency_tracer.h"
+
+#ifdef TRACE_LATENCY
+
+#include "progmem.h"
+
+#define FLAG_PARSED 0x01
+#define FLAG_COMMITTED 0x02
+#define FLAG_FLUSHED 0x04
+#define FLAG_ENCODER 0x08
+
+#define STAGE_NAME_SIZE 7
+const char stage_names[LatencyTracer::NUM_STAGES][STAGE_NAME_SIZE] PROGMEM = {"enc", "parse", "commit", "lcd", "total"};
+
+LatencyTracer::LatencyTracer(){
+	reset();
+}
+
+// received is when the frame's bytes were taken from the UART
+void LatencyTracer::parsed(byte sequence, unsigned long received, unsigned long time){
+	Event *event = &_events[_next_event];
+	_next_event = (_next_event + 1) % MAX_EVENTS;
+
+	event->sequence = sequence;
+	event->flags = FLAG_PARSED;
+	event->received = received;
+	event->parsed = time;
+	add(STAGE_PARSE, time - received);
+}
+
+void LatencyTracer::committed(unsigned long time){
+	for(byte i = 0; i < MAX_EVENTS; i++){
+		Event *event = &_events[i];
+		if((event->flags & FLAG_PARSED) && !(event->flags & FLAG_COMMITTED)){
+			event->flags |= FLAG_COMMITTED;
+			add(STAGE_COMMIT, time - event->parsed);
+		}
+	}
+}
+
+void LatencyTracer::flushed(unsigned long time){
+	for(byte i = 0; i < MAX_EVENTS; i++){
+		Event *event = &_events[i];
+		if((event->flags & FLAG_PARSED) && !(event->flags & FLAG_FLUSHED)){
+			event->flags |= FLAG_FLUSHED;
+			event->flushed = time;
+			add(STAGE_DISPLAY, time - event->parsed);
+			if(event->flags & FLAG_ENCODER){
+				add(STAGE_TOTAL, event->encoder + (time - event->received));
+				event->flags = 0;
+			}
+		}
+	}
+}
+
+// the encoder board's share, in microseconds
+void LatencyTracer::encoder_latency(byte sequence, unsigned long latency){
+	add(STAGE_ENCODER, latency);
+
+	Event *event = find(sequence, FLAG_ENCODER);
+	if(event == NULL)
+		return;
+	if(event->flags & FLAG_FLUSHED){
+		add(STAGE_TOTAL, latency + (event->flushed - event->received));
+		event->flags = 0;
+	} else {
+		event->flags |= FLAG_ENCODER;
+		event->encoder = latency;
+	}
+}
+
+unsigned int LatencyTracer::count(byte stage, byte bucket){
+	if(stage >= NUM_STAGES || bucket >= NUM_BUCKETS)
+		return 0;
+	return _histogram[stage][bucket];
+}
+
+// a header of bucket limits in microseconds, then a line of counts per stage
+void LatencyTracer::dump(Print *out){
+	out->print("us");
+	for(byte bucket = 0; bucket < NUM_BUCKETS - 1; bucket++){
+		out->print(" <");
+		out->print((long)BUCKET_US << bucket);
+	}
+	out->println(" more");
+
+	char name[STAGE_NAME_SIZE];
+	for(byte stage = 0; stage < NUM_STAGES; stage++){
+		progmem_copy(name, stage_names[stage]);
+		out->print(name);
+		for(byte bucket = 0; bucket < NUM_BUCKETS; bucket++){
+			out->print(" ");
+			out->print((long)_histogram[stage][bucket]);
+		}
+		out->println();
+	}
+}
+
+void LatencyTracer::reset(){
+	memset(_events, 0, sizeof(_events));
+	memset(_histogram, 0, sizeof(_histogram));
+	_next_event = 0;
+}
+
+void LatencyTracer::add(byte stage, unsigned long latency){
+	byte bucket = 0;
+	latency /= BUCKET_US;
+	while(latency && bucket < NUM_BUCKETS - 1){
+		latency >>= 1;
+		bucket++;
+	}
+	if(_histogram[stage][bucket] != 0xffff)
+		_histogram[stage][bucket]++;
+}
+
+// the newest followed turn with this sequence number that is still missing the flag
+LatencyTracer::Event *LatencyTracer::find(byte sequence, byte flag){
+	for(byte i = 1; i <= MAX_EVENTS; i++){
+		Event *event = &_events[(_next_event + MAX_EVENTS - i) % MAX_EVENTS];
+		if((event->flags & FLAG_PARSED) && event->sequence == sequence && !(event->flags & flag))
+			return event;
+	}
+	return NULL;
+}
+
+#endif
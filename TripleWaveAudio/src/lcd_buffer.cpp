@@ -0,0 +1,74 @@
+#include "lcd_buffer.h"
+
+LCDBuffer::LCDBuffer(hd44780_I2Cexp *lcd){
+	_lcd = lcd;
+	_col = 0;
+	_row = 0;
+
+	// lcd.begin() leaves the panel cleared
+	memset(_pending, ' ', sizeof(_pending));
+	memset(_shown, ' ', sizeof(_shown));
+	for(byte row = 0; row < ROWS; row++)
+		_dirty[row] = false;
+}
+
+// like the hd44780 library, rows past the end land on the last row
+void LCDBuffer::setCursor(byte col, byte row){
+	_col = col;
+	_row = row < ROWS ? row : ROWS - 1;
+}
+
+size_t LCDBuffer::write(uint8_t value){
+	if(_col >= COLS)
+		return 0;
+	if(_pending[_row][_col] != (char)value){
+		_pending[_row][_col] = value;
+		_dirty[_row] = true;
+	}
+	_col++;
+	return 1;
+}
+
+size_t LCDBuffer::write(const char *buffer){
+	size_t n = 0;
+	while(*buffer)
+		n += write((uint8_t)*buffer++);
+	return n;
+}
+
+void LCDBuffer::fill(char value, byte count){
+	while(count--)
+		write((uint8_t)value);
+}
+
+// one setCursor per run of changed cells, then the run's characters
+void LCDBuffer::flush(){
+	for(byte row = 0; row < ROWS; row++){
+		if(!_dirty[row])
+			continue;
+
+		byte col = 0;
+		while(col < COLS){
+			if(_pending[row][col] == _shown[row][col]){
+				col++;
+				continue;
+			}
+
+			_lcd->setCursor(col, row);
+			while(col < COLS && _pending[row][col] != _shown[row][col]){
+				_lcd->write((uint8_t)_pending[row][col]);
+				_shown[row][col] = _pending[row][col];
+				col++;
+			}
+		}
+		_dirty[row] = false;
+	}
+}
+
+// forget what the panel shows so the next flush repaints every cell
+// (0xff is the solid block glyph, which is never rendered)
+void LCDBuffer::invalidate(){
+	memset(_shown, 0xff, sizeof(_shown));
+	for(byte row = 0; row < ROWS; row++)
+		_dirty[row] = true;
+}
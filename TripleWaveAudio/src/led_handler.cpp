@@ -1,9 +1,22 @@
 #include <Arduino.h>
 #include "led_handler.h"
+#include "progmem.h"
+
+#define LEVEL_OFF 0
+#define LEVEL_FULL 255
+
+#ifdef __AVR__
+static LEDHandler *timer_leds = NULL;
+
+// Timer2 runs the PWM on pins 3 and 11, its overflow comes at about 490 Hz
+ISR(TIMER2_OVF_vect){
+	timer_leds->tick();
+}
+#endif
 
 LEDHandler::LEDHandler(int num_leds, const int *led_pins, const int *intensity, int show_time, int blank_time){
 	_led_pins = led_pins;
-	_num_leds = num_leds;
+	_num_leds = num_leds > MAX_LEDS ? MAX_LEDS : num_leds;
 	_intensity = intensity;
 	_show_time = show_time;
 	_blank_time = blank_time;
@@ -16,15 +29,28 @@ LEDHandler::LEDHandler(int num_leds, const int *led_pins, const int *intensity,
 	_blanking = false;
 	_active = 0; 		 // virtual current active led or other state
 	_enabled = NULL;	 // array of enabled leds for animation matching LED count
+
+	_animating = false;
+	_flash_state = false;
+	_pwm = 0;
+	for(int i = 0; i < _num_leds; i++){
+		_levels[i] = LEVEL_OFF;
+#ifdef __AVR__
+		_ports[i] = portOutputRegister(digitalPinToPort(pin(i)));
+		_masks[i] = digitalPinToBitMask(pin(i));
+#endif
+	}
 }
 
+// starts an animation, it runs from tick() until stop()
 void LEDHandler::begin(unsigned long time, int style, int show_time, int blank_time, bool *enabled){
+	_animating = false;
 	_show_time = show_time ? show_time : DEFAULT_SHOW_TIME;
 	_blank_time = blank_time ? blank_time : DEFAULT_BLANK_TIME;
 
 	// if enabled specified, disable it if none of the LEDs are enabled
 	bool detect = false;
-	for(int i = 0; i < _num_leds; i++){
+	for(int i = 0; enabled != NULL && i < _num_leds; i++){
 		if(enabled[i]){
 			detect = true;
 			break;
@@ -57,20 +83,46 @@ void LEDHandler::begin(unsigned long time, int style, int show_time, int blank_t
 
 	_active = -1;
 	_blanking = false;
+	_animating = true;
+}
+
+// ends an animation and turns off its LED
+void LEDHandler::stop(){
+	_animating = false;
+	if(_active != -1)
+		deactivate_led(_active, _style & STYLE_MIRROR);
+	_active = -1;
+}
+
+// hands animation and flashes to the Timer2 overflow interrupt
+void LEDHandler::attach_timer(){
+#ifdef __AVR__
+	noInterrupts();
+	timer_leds = this;
+	TIMSK2 |= _BV(TOIE2);
+	interrupts();
+#endif
+}
+
+// from the timer interrupt, or straight from loop() without one
+void LEDHandler::tick(){
+	unsigned long time = millis();
+	if(_animating)
+		step(time);
+	if(_flash_state)
+		step_flash(time);
 }
 
 void LEDHandler::deactivate_led(int virtual_pin, bool mirror){
-	digitalWrite(_led_pins[virtual_pin], LOW);
+	write_led(virtual_pin, LEVEL_OFF);
 	if(mirror)
 		deactivate_led(virtual_pin + (_num_leds / 2));
 }
 
 void LEDHandler::activate_led(int virtual_pin, bool mirror){
 
-	if(_intensity[virtual_pin] == 0)
-		digitalWrite(_led_pins[virtual_pin], HIGH);
-	else
-		analogWrite(_led_pins[virtual_pin], _intensity[virtual_pin]);
+	int value = intensity(virtual_pin);
+	write_led(virtual_pin, value == 0 ? LEVEL_FULL : value);
 	if(mirror)
 		activate_led(virtual_pin + (_num_leds / 2));
 }
@@ -122,24 +174,13 @@ void LEDHandler::activate_leds(const volatile bool * states, bool mirror){
 
 // turn all on or off
 void LEDHandler::activate_all(bool state, bool mirror){
-
 	int effective_pins = mirror ? (_num_leds / 2) : _num_leds;
-
-
-
 	for(int virtual_pin = 0; virtual_pin < effective_pins; virtual_pin++){
-
-		if(state){
-
-
+		if(state)
 			activate_led(virtual_pin, mirror);
-		} else {
-
+		else
 			deactivate_led(virtual_pin, mirror);
-		}
 	}
-
-
 }
 
 void LEDHandler::deactivate_leds(bool mirror){
@@ -153,17 +194,17 @@ void LEDHandler::flash_leds(bool mirror, long time){
 	int effective_pins = mirror ? (_num_leds / 2) : _num_leds;
 
 	for(int virtual_pin = 0; virtual_pin < effective_pins; virtual_pin++){
-		digitalWrite(_led_pins[virtual_pin], HIGH);
+		write_led(virtual_pin, LEVEL_FULL);
 		if(mirror)
-			digitalWrite(_led_pins[virtual_pin] + (_num_leds / 2), HIGH);
+			write_led(virtual_pin + (_num_leds / 2), LEVEL_FULL);
 	}
 
 	delay(effective_time);
 
 	for(int virtual_pin = 0; virtual_pin < effective_pins; virtual_pin++){
-		digitalWrite(_led_pins[virtual_pin], LOW);
+		write_led(virtual_pin, LEVEL_OFF);
 		if(mirror)
-			digitalWrite(_led_pins[virtual_pin] + (_num_leds / 2), LOW);
+			write_led(virtual_pin + (_num_leds / 2), LEVEL_OFF);
 	}
 }
 
@@ -173,14 +214,15 @@ void LEDHandler::begin_flash(bool mirror, int on_time){
 	_flash_pins = mirror ? (_num_leds / 2) : _num_leds;
 
 	for(int virtual_pin = 0; virtual_pin < _flash_pins; virtual_pin++){
-		digitalWrite(_led_pins[virtual_pin], HIGH);
+		write_led(virtual_pin, LEVEL_FULL);
 		if(_flash_mirror)
-			digitalWrite(_led_pins[virtual_pin] + (_num_leds / 2), HIGH);
+			write_led(virtual_pin + (_num_leds / 2), LEVEL_FULL);
 	}
 
+	// tick() turns them off again
 	_flash_on_time = on_time != 0 ? on_time : DEFAULT_FLASH_TIME;
-	_flash_state = true;
 	_next_flash_change = millis() + _flash_on_time;
+	_flash_state = true;
 }
 
 // returns true to keep going
@@ -195,10 +237,51 @@ bool LEDHandler::step_flash(unsigned long time){
 
 	// currently on, turn off
 	for(int virtual_pin = 0; virtual_pin < _flash_pins; virtual_pin++){
-		digitalWrite(_led_pins[virtual_pin], LOW);
+		write_led(virtual_pin, LEVEL_OFF);
 		if(_flash_mirror)
-			digitalWrite(_led_pins[virtual_pin] + (_num_leds / 2), LOW);
+			write_led(virtual_pin + (_num_leds / 2), LEVEL_OFF);
 	}
 	_flash_state = false;
 	return false;
 }
+
+int LEDHandler::num_leds(){
+	return _num_leds;
+}
+
+int LEDHandler::pin(int virtual_pin){
+	return progmem_read(&_led_pins[virtual_pin]);
+}
+
+int LEDHandler::intensity(int virtual_pin){
+	return progmem_read(&_intensity[virtual_pin]);
+}
+
+// only a change of level reaches the pin; fully on and off go through the port
+// register, except that leaving PWM needs digitalWrite() to disconnect the timer
+void LEDHandler::write_led(int virtual_pin, byte level){
+	if(virtual_pin < 0 || virtual_pin >= _num_leds || _levels[virtual_pin] == level)
+		return;
+	_levels[virtual_pin] = level;
+
+	byte bit = 1 << virtual_pin;
+	if(level != LEVEL_OFF && level != LEVEL_FULL){
+		analogWrite(pin(virtual_pin), level);
+		_pwm |= bit;
+	} else if(_pwm & bit){
+		digitalWrite(pin(virtual_pin), level == LEVEL_OFF ? LOW : HIGH);
+		_pwm &= ~bit;
+	} else {
+#ifdef __AVR__
+		byte sreg = SREG;
+		noInterrupts();
+		if(level == LEVEL_OFF)
+			*_ports[virtual_pin] &= ~_masks[virtual_pin];
+		else
+			*_ports[virtual_pin] |= _masks[virtual_pin];
+		SREG = sreg;
+#else
+		digitalWrite(pin(virtual_pin), level == LEVEL_OFF ? LOW : HIGH);
+#endif
+	}
+}
@@ -0,0 +1,86 @@
+#include "notes.h"
+#include "progmem.h"
+
+#define NOTE_OCTAVE(entry, octave) \
+	entry((octave) * 12), entry((octave) * 12 + 1), entry((octave) * 12 + 2), entry((octave) * 12 + 3), \
+	entry((octave) * 12 + 4), entry((octave) * 12 + 5), entry((octave) * 12 + 6), entry((octave) * 12 + 7), \
+	entry((octave) * 12 + 8), entry((octave) * 12 + 9), entry((octave) * 12 + 10), entry((octave) * 12 + 11)
+
+#define NOTE_TABLE(entry) \
+	NOTE_OCTAVE(entry, 0), NOTE_OCTAVE(entry, 1), NOTE_OCTAVE(entry, 2), NOTE_OCTAVE(entry, 3), \
+	NOTE_OCTAVE(entry, 4), NOTE_OCTAVE(entry, 5), NOTE_OCTAVE(entry, 6), NOTE_OCTAVE(entry, 7), \
+	NOTE_OCTAVE(entry, 8), NOTE_OCTAVE(entry, 9)
+
+#define NOTE_FREQUENCY(note) note_frequency(note)
+#define NOTE_WORD(note) AD9833Driver::tuning_word(note_frequency(note))
+
+static_assert(NUM_NOTES == 10 * 12, "NOTE_TABLE covers ten octaves");
+
+const long note_frequencies[NUM_NOTES] PROGMEM = {NOTE_TABLE(NOTE_FREQUENCY)};
+const uint32_t note_words[NUM_NOTES] PROGMEM = {NOTE_TABLE(NOTE_WORD)};
+
+#define NOTE_NAME_SIZE 3
+const char note_names[12][NOTE_NAME_SIZE] PROGMEM = {
+	"C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"
+};
+
+long note_to_frequency(int note){
+	return progmem_read(&note_frequencies[note]);
+}
+
+uint32_t note_to_word(int note){
+	return progmem_read(&note_words[note]);
+}
+
+// the highest note not above frequency, NO_NOTE below C0, a binary search of the table
+int note_at_or_below(long frequency){
+	int low = 0;
+	int high = NUM_NOTES;
+	while(low < high){
+		int middle = (low + high) / 2;
+		if(note_to_frequency(middle) <= frequency)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	return low - 1;
+}
+
+// the note closest in pitch, the lower one unless frequency is above their geometric mean
+int nearest_note(long frequency){
+	int note = note_at_or_below(frequency);
+	if(note == NO_NOTE)
+		return 0;
+	if(note == NUM_NOTES - 1)
+		return note;
+	uint64_t square = (uint64_t)frequency * frequency;
+	if(square > (uint64_t)note_to_frequency(note) * note_to_frequency(note + 1))
+		return note + 1;
+	return note;
+}
+
+// e.g. "C#5", right aligned like the numbers, "~" in front when the frequency is off the note
+void format_note(int note, bool exact, char *field, byte width){
+	char text[NOTE_NAME_SIZE + 2];
+	byte length = 0;
+
+	if(!exact)
+		text[length++] = '~';
+	byte octave = 0;
+	while(note >= 12){
+		note -= 12;
+		octave++;
+	}
+	char name[NOTE_NAME_SIZE];
+	progmem_copy(name, note_names[note]);
+	for(byte i = 0; name[i]; i++)
+		text[length++] = name[i];
+	text[length++] = '0' + octave;
+
+	if(length > width)
+		length = width;
+	byte pad = width - length;
+	memset(field, ' ', pad);
+	memcpy(field + pad, text, length);
+	field[width] = '\0';
+}
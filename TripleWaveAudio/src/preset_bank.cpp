@@ -0,0 +1,126 @@
+#include <EEPROM.h>
+#include "preset_bank.h"
+
+#define NO_SLOT 0xff
+#define NO_COPY 0xff
+
+PresetBank::PresetBank(){
+	_copies = 0;
+	for(byte slot = 0; slot < NUM_SLOTS; slot++){
+		_newest[slot] = NO_COPY;
+		_sequence[slot] = 0;
+	}
+	_dirty = false;
+	_settle_time = 0;
+	_store_slot = NO_SLOT;
+	_write_address = 0;
+	_write_index = sizeof(Record);
+}
+
+// finds the newest good copy of each slot
+void PresetBank::begin(){
+	_copies = EEPROM.length() / (sizeof(Record) * NUM_SLOTS);
+
+	Record record;
+	for(byte slot = 0; slot < NUM_SLOTS; slot++){
+		for(byte copy = 0; copy < _copies; copy++){
+			if(!read(slot, copy, &record))
+				continue;
+			if(_newest[slot] == NO_COPY || (int16_t)(record.sequence - _sequence[slot]) > 0){
+				_newest[slot] = copy;
+				_sequence[slot] = record.sequence;
+			}
+		}
+	}
+}
+
+// loads a slot into the handlers and commits all generators in one batched update
+// returns false if the slot has never been written
+bool PresetBank::recall(byte slot, GeneratorHandler **handlers, int num_handlers){
+	Record record;
+	if(slot >= NUM_SLOTS || _newest[slot] == NO_COPY || !read(slot, _newest[slot], &record))
+		return false;
+
+	for(int i = 0; i < num_handlers && i < MAX_GENERATORS; i++)
+		handlers[i]->load_settings(&record.generators[i]);
+	GeneratorHandler::update_generators(handlers, num_handlers);
+	return true;
+}
+
+// the handlers are captured when the write starts
+void PresetBank::store(byte slot){
+	if(slot < NUM_SLOTS)
+		_store_slot = slot;
+}
+
+// something changed, the last state is saved once it has settled for SETTLE_TIME
+void PresetBank::changed(unsigned long time){
+	_dirty = true;
+	_settle_time = time + SETTLE_TIME;
+}
+
+// called every pass of loop(): at most one EEPROM byte, and only when the EEPROM is ready
+void PresetBank::service(unsigned long time, GeneratorHandler **handlers, int num_handlers){
+	if(_write_index < sizeof(Record)){
+		if(eeprom_is_ready()){
+			EEPROM.update(_write_address + _write_index, ((byte *)&_record)[_write_index]);
+			if(++_write_index == sizeof(Record)){
+				_newest[_record.slot] = (_write_address / sizeof(Record)) - (_record.slot * _copies);
+				_sequence[_record.slot] = _record.sequence;
+			}
+		}
+		return;
+	}
+
+	if(_store_slot != NO_SLOT){
+		start_write(_store_slot, handlers, num_handlers);
+		_store_slot = NO_SLOT;
+	} else if(_dirty && (long)(time - _settle_time) >= 0){
+		start_write(LAST_STATE, handlers, num_handlers);
+		_dirty = false;
+	}
+}
+
+// finishes any write and saves the last state now, blocking; used before a reset
+void PresetBank::flush(GeneratorHandler **handlers, int num_handlers){
+	if(_dirty)
+		_settle_time = millis();
+	while(_write_index < sizeof(Record) || _store_slot != NO_SLOT || _dirty)
+		service(millis(), handlers, num_handlers);
+}
+
+byte PresetBank::checksum(const Record *record){
+	const byte *bytes = (const byte *)record;
+	byte sum = 0;
+	for(byte i = 0; i < sizeof(Record); i++){
+		if(bytes + i != &record->checksum)
+			sum += bytes[i];
+	}
+	return ~sum;
+}
+
+int PresetBank::address(byte slot, byte copy){
+	return (slot * _copies + copy) * sizeof(Record);
+}
+
+bool PresetBank::read(byte slot, byte copy, Record *record){
+	EEPROM.get(address(slot, copy), *record);
+	return record->slot == slot && record->checksum == checksum(record);
+}
+
+// snapshots the handlers into the next copy of the slot, round-robin
+void PresetBank::start_write(byte slot, GeneratorHandler **handlers, int num_handlers){
+	if(_copies == 0)
+		return;
+
+	memset(&_record, 0, sizeof(Record));
+	_record.sequence = _sequence[slot] + 1;
+	_record.slot = slot;
+	for(int i = 0; i < num_handlers && i < MAX_GENERATORS; i++)
+		handlers[i]->save_settings(&_record.generators[i]);
+	_record.checksum = checksum(&_record);
+
+	byte copy = _newest[slot] == NO_COPY ? 0 : (_newest[slot] + 1) % _copies;
+	_write_address = address(slot, copy);
+	_write_index = 0;
+}
@@ -0,0 +1,60 @@
+#include "profiler.h"
+
+#ifdef PROFILE_SECTIONS
+
+#include "progmem.h"
+
+struct ProfileEntry {
+	unsigned int count;
+	unsigned int min;
+	unsigned int max;
+	unsigned long total;
+};
+
+static ProfileEntry profile_table[PROFILE_NUM_SECTIONS];
+
+#define PROFILE_NAME_SIZE 7
+const char profile_names[PROFILE_NUM_SECTIONS][PROFILE_NAME_SIZE] PROGMEM = {
+	"show0", "show1", "show2", "show3", "sep", "serial", "handle", "synced", "update", "flush"
+};
+
+void profiler_record(byte section, unsigned long elapsed){
+	if(section >= PROFILE_NUM_SECTIONS)
+		return;
+
+	ProfileEntry *entry = &profile_table[section];
+	unsigned int time = elapsed > 0xffff ? 0xffff : elapsed;
+	if(entry->count == 0 || time < entry->min)
+		entry->min = time;
+	if(time > entry->max)
+		entry->max = time;
+	entry->total += elapsed;
+	if(entry->count != 0xffff)
+		entry->count++;
+}
+
+// one line per section that ran: name count min max total, in microseconds
+void profiler_dump(Print *out){
+	char name[PROFILE_NAME_SIZE];
+	for(byte section = 0; section < PROFILE_NUM_SECTIONS; section++){
+		ProfileEntry *entry = &profile_table[section];
+		if(entry->count == 0)
+			continue;
+		progmem_copy(name, profile_names[section]);
+		out->print(name);
+		out->print(" ");
+		out->print((long)entry->count);
+		out->print(" ");
+		out->print((long)entry->min);
+		out->print(" ");
+		out->print((long)entry->max);
+		out->print(" ");
+		out->println((long)entry->total);
+	}
+}
+
+void profiler_reset(){
+	memset(profile_table, 0, sizeof(profile_table));
+}
+
+#endif
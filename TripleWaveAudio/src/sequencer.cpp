@@ -0,0 +1,205 @@
+#include <SPI.h>
+#include "lcd_buffer.h"
+#include "led_handler.h"
+#include "ad9833_driver.h"
+#include "generator_handler.h"
+#include "sweep_engine.h"
+#include "sequencer.h"
+#include "progmem.h"
+
+#define TICKS_PER_MS (1000 / SweepEngine::TICK_US)
+
+#ifdef __AVR__
+static Sequencer *timer_sequencer = NULL;
+
+ISR(TIMER1_COMPB_vect){
+	timer_sequencer->tick();
+}
+#endif
+
+Sequencer::Sequencer(){
+	_handlers = NULL;
+	_num_handlers = 0;
+	_steps = NULL;
+	_count = 0;
+	_loop = false;
+	_index = 0;
+	_running = false;
+	_countdown = 0;
+	_subticks = 0;
+	_owned = 0;
+	_next_refresh = 0;
+}
+
+// after SweepEngine::begin(), compare B fires halfway through the sweep tick period
+void Sequencer::begin(GeneratorHandler **handlers, byte num_handlers){
+	_handlers = handlers;
+	_num_handlers = num_handlers > MAX_HANDLERS ? MAX_HANDLERS : num_handlers;
+#ifdef __AVR__
+	timer_sequencer = this;
+	OCR1B = OCR1A / 2;
+#endif
+}
+
+// sequence is in PROGMEM, the first step plays on the next tick
+// returns false if the sequence cannot be played
+bool Sequencer::start(const Sequence *sequence){
+	Sequence header = progmem_read(sequence);
+	const SequenceStep *steps = header.steps;
+	byte count = header.count;
+	bool loop = header.loop;
+
+	// a looping sequence needs time between its boundaries
+	byte owned = 0;
+	bool timed = false;
+	for(byte i = 0; i < count; i++){
+		SequenceStep step = progmem_read(&steps[i]);
+		if(step.generator >= _num_handlers)
+			return false;
+		owned |= 1 << step.generator;
+		timed |= step.duration != 0;
+	}
+	if(count == 0 || (loop && !timed))
+		return false;
+
+	stop();
+
+	for(byte i = 0; i < _num_handlers; i++){
+		if(owned & (1 << i)){
+			GeneratorHandler *handler = _handlers[i];
+			handler->_sweeping = true;
+			_words[i] = AD9833Driver::tuning_word(handler->_frequency);
+			_states[i] = handler->_state;
+		}
+	}
+
+	noInterrupts();
+	_steps = steps;
+	_count = count;
+	_loop = loop;
+	_index = 0;
+	_owned = owned;
+	_countdown = 1;
+	_subticks = 1;
+	_running = true;
+	enable_timer(true);
+	interrupts();
+	return true;
+}
+
+// leaves each generator on the step it had reached
+void Sequencer::stop(){
+	noInterrupts();
+	_running = false;
+	enable_timer(false);
+	interrupts();
+	finish();
+}
+
+bool Sequencer::running(){
+	return _running;
+}
+
+// whether the sequence playing, or just ended, holds the generator
+bool Sequencer::active(GeneratorHandler *handler){
+	for(byte i = 0; i < _num_handlers; i++){
+		if(_handlers[i] == handler)
+			return (_owned & (1 << i)) != 0;
+	}
+	return false;
+}
+
+// timer interrupt: count down to the step boundary
+void Sequencer::tick(){
+	if(!_running || --_subticks != 0)
+		return;
+	_subticks = TICKS_PER_MS;
+	if(--_countdown != 0)
+		return;
+	play_steps();
+}
+
+// plays the step due and any 0 duration steps after it
+// a step on its own goes straight into the running register, the steps of a chord are staged
+// in the idle register sets and all switch over at once
+void Sequencer::play_steps(){
+	AD9833Driver *staged[MAX_HANDLERS];
+	byte count = 0;
+	byte chord = 0;
+
+	do {
+		if(_index == _count){
+			if(!_loop){
+				_running = false;
+				enable_timer(false);
+				break;
+			}
+			_index = 0;
+		}
+
+		SequenceStep step = progmem_read(&_steps[_index++]);
+		GeneratorHandler *handler = _handlers[step.generator];
+		AD9833Driver *generator = handler->_generator;
+		// a muted step stops the generator at 0 Hz, as STATE_MUTED does
+		uint32_t word = step.state == GeneratorHandler::STATE_MUTED ? 0 : step.word;
+		_words[step.generator] = step.word;
+		_states[step.generator] = step.state;
+		_countdown = step.duration;
+
+		if(_countdown != 0 && chord == 0){
+			generator->set_frequency(generator->active(), word);
+		} else {
+			generator->stage(word, AD9833Driver::phase_word(handler->_last_set_phase), handler->_last_set_mode);
+			if(!(chord & (1 << step.generator)))
+				staged[count++] = generator;
+			chord |= 1 << step.generator;
+		}
+	} while(_countdown == 0);
+
+	AD9833Driver::commit(staged, count);
+}
+
+// from loop(): show the steps played, and hand the generators back once a one-shot ends
+void Sequencer::refresh(unsigned long time){
+	if(_owned == 0 || (long)(time - _next_refresh) < 0)
+		return;
+	_next_refresh = time + DISPLAY_INTERVAL;
+
+	for(byte i = 0; i < _num_handlers; i++){
+		if(!(_owned & (1 << i)))
+			continue;
+		noInterrupts();
+		uint32_t word = _words[i];
+		byte state = _states[i];
+		interrupts();
+		_handlers[i]->_frequency = AD9833Driver::frequency(word);
+		_handlers[i]->_state = state;
+	}
+
+	if(!_running)
+		finish();
+}
+
+void Sequencer::finish(){
+	for(byte i = 0; i < _num_handlers; i++){
+		if(!(_owned & (1 << i)))
+			continue;
+		GeneratorHandler *handler = _handlers[i];
+		handler->_frequency = AD9833Driver::frequency(_words[i]);
+		handler->_state = _states[i];
+		handler->_last_set_freq = handler->_state == GeneratorHandler::STATE_MUTED ? handler->_silent_freq : handler->_frequency;
+		handler->_sweeping = false;
+	}
+	_owned = 0;
+}
+
+void Sequencer::enable_timer(bool enable){
+#ifdef __AVR__
+	if(enable){
+		TIFR1 = _BV(OCF1B);
+		TIMSK1 |= _BV(OCIE1B);
+	} else {
+		TIMSK1 &= ~_BV(OCIE1B);
+	}
+#endif
+}
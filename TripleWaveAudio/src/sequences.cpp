@@ -0,0 +1,58 @@
+#include "ad9833_driver.h"
+#include "generator_handler.h"
+#include "sequences.h"
+#include "notes.h"
+
+// frequencies in 1/10 Hz, the tuning words are worked out by the compiler
+#define STEP(generator, frequency, duration, state) \
+	{AD9833Driver::tuning_word(frequency), duration, generator, GeneratorHandler::state}
+
+// notes follow NOTE_A4
+#define NOTE_STEP(generator, semitone, octave, duration, state) \
+	STEP(generator, note_frequency(note_index(semitone, octave)), duration, state)
+
+// C major scale on generator A, looping
+const SequenceStep scale_steps[] PROGMEM = {
+	NOTE_STEP(0, NOTE_C, 4, 250, STATE_NORMAL),
+	NOTE_STEP(0, NOTE_D, 4, 250, STATE_NORMAL),
+	NOTE_STEP(0, NOTE_E, 4, 250, STATE_NORMAL),
+	NOTE_STEP(0, NOTE_F, 4, 250, STATE_NORMAL),
+	NOTE_STEP(0, NOTE_G, 4, 250, STATE_NORMAL),
+	NOTE_STEP(0, NOTE_A, 4, 250, STATE_NORMAL),
+	NOTE_STEP(0, NOTE_B, 4, 250, STATE_NORMAL),
+	NOTE_STEP(0, NOTE_C, 5, 500, STATE_NORMAL),
+	STEP(0, 0L, 250, STATE_MUTED),
+};
+
+// I IV V I on all three generators, each chord changing on one boundary, once
+const SequenceStep chord_steps[] PROGMEM = {
+	NOTE_STEP(0, NOTE_C, 4, 0, STATE_NORMAL),
+	NOTE_STEP(1, NOTE_E, 4, 0, STATE_NORMAL),
+	NOTE_STEP(2, NOTE_G, 4, 600, STATE_NORMAL),
+	NOTE_STEP(0, NOTE_F, 4, 0, STATE_NORMAL),
+	NOTE_STEP(1, NOTE_A, 4, 0, STATE_NORMAL),
+	NOTE_STEP(2, NOTE_C, 5, 600, STATE_NORMAL),
+	NOTE_STEP(0, NOTE_G, 4, 0, STATE_NORMAL),
+	NOTE_STEP(1, NOTE_B, 4, 0, STATE_NORMAL),
+	NOTE_STEP(2, NOTE_D, 5, 600, STATE_NORMAL),
+	NOTE_STEP(0, NOTE_C, 4, 0, STATE_NORMAL),
+	NOTE_STEP(1, NOTE_E, 4, 0, STATE_NORMAL),
+	NOTE_STEP(2, NOTE_G, 4, 1200, STATE_NORMAL),
+	STEP(0, 0L, 0, STATE_MUTED),
+	STEP(1, 0L, 0, STATE_MUTED),
+	STEP(2, 0L, 0, STATE_MUTED),
+};
+
+// 1 kHz tone bursts on generator A, 10 ms on and 90 ms off, looping
+const SequenceStep burst_steps[] PROGMEM = {
+	STEP(0, 10000L, 10, STATE_NORMAL),
+	STEP(0, 10000L, 90, STATE_MUTED),
+};
+
+#define COUNT(steps) (sizeof(steps) / sizeof(steps[0]))
+
+const Sequence sequences[NUM_SEQUENCES] PROGMEM = {
+	{scale_steps, COUNT(scale_steps), true},
+	{chord_steps, COUNT(chord_steps), false},
+	{burst_steps, COUNT(burst_steps), true},
+};
@@ -0,0 +1,280 @@
+#include <ctype.h>
+#include "serial_parser.h"
+
+#define RING_MASK (RING_SIZE - 1)
+#define MAX_VALUE 0x7fffffffL	// avr-libc only defines INT32_MAX for C++ with __STDC_LIMIT_MACROS
+
+SerialParser::SerialParser(HardwareSerial *serial){
+	_serial = serial;
+	_head = 0;
+	_tail = 0;
+	_length = 0;
+	_overflowed = false;
+	_last_sequence = -1;
+	_received_time = 0;
+	_value = 0;
+	_malformed_count = 0;
+	_overflowed_count = 0;
+}
+
+// takes only what has already arrived, bytes that do not fit wait in the UART
+void SerialParser::receive(){
+	int available = _serial->available();
+	if(available > 0)
+		_received_time = micros();
+	while(available-- > 0 && (byte)(_head - _tail) < RING_SIZE)
+		_ring[_head++ & RING_MASK] = _serial->read();
+}
+
+// returns false once the ring holds no further complete frame
+bool SerialParser::next_command(int &id, int &data, int &steps){
+	while(_tail != _head){
+		byte c = _ring[_tail++ & RING_MASK];
+		if(c == LINK_SYNC || _link.receiving()){
+			if(_link.receive(c) && parse_link(id, data, steps))
+				return true;
+			continue;
+		}
+
+		switch(c){
+			case '\r':
+				break;
+			case '\n':
+				if(parse_frame(id, data, steps))
+					return true;
+				break;
+			default:
+				if(_length < FRAME_SIZE)
+					_frame[_length++] = c;
+				else
+					_overflowed = true;
+				break;
+		}
+	}
+	return false;
+}
+
+// a text frame is the handler id followed by either an event digit
+// or a signed detent count of one or two digits, or a preset command and slot,
+// or an absolute setting, or a sweep, or a bulk bracket
+// steps is the signed number of detents for rotation events
+bool SerialParser::parse_frame(int &id, int &data, int &steps){
+	bool valid = false;
+	if(_overflowed){
+		_overflowed_count++;
+	} else if(_length == 1 && (_frame[0] == '[' || _frame[0] == ']')){
+		id = _frame[0] == '[' ? 1 : 0;
+		data = EVENT_BULK;
+		steps = 0;
+		valid = true;
+	} else if(_frame[0] == '='){
+		valid = parse_setting(id, data, steps);
+	} else if(_frame[0] == 'W'){
+		valid = parse_sweep(id, data, steps);
+	} else if(_length == 2 && (_frame[0] == 'P' || _frame[0] == 'S' || _frame[0] == 'T' || _frame[0] == 'Q') && isdigit(_frame[1])){
+		id = _frame[1] - '0';
+		switch(_frame[0]){
+			case 'P':
+				data = EVENT_RECALL;
+				break;
+			case 'S':
+				data = EVENT_STORE;
+				break;
+			case 'T':
+				data = EVENT_TRACE;
+				break;
+			default:
+				data = EVENT_SEQUENCE;
+				break;
+		}
+		steps = 0;
+		valid = true;
+	} else if(_length >= 2 && _frame[0] >= '0' && _frame[0] < '3'){
+		id = _frame[0] - '0';
+		if(_length == 2 && _frame[1] >= '0' && _frame[1] <= '0' + EVENT_DELTA){
+			// the encoder events only, the other event codes have frames of their own
+			data = _frame[1] - '0';
+			steps = data == EVENT_DECREMENT ? -1 : (data == EVENT_INCREMENT ? 1 : 0);
+			valid = true;
+		} else if(_length >= 3 && (_frame[1] == '+' || _frame[1] == '-') && isdigit(_frame[2]) && (_length == 3 || isdigit(_frame[3]))){
+			data = EVENT_DELTA;
+			steps = _frame[2] - '0';
+			if(_length == 4)
+				steps = steps * 10 + (_frame[3] - '0');
+			if(_frame[1] == '-')
+				steps = -steps;
+			valid = true;
+		}
+	}
+
+	if(!valid && !_overflowed && _length != 0)
+		_malformed_count++;
+
+	_length = 0;
+	_overflowed = false;
+	_last_sequence = -1;
+	return valid;
+}
+
+// "=<id or *><field><value>", the frequency and phase take one optional decimal place
+bool SerialParser::parse_setting(int &id, int &data, int &steps){
+	if(_length < 4)
+		return false;
+
+	if(_frame[1] == '*')
+		id = SET_ALL;
+	else if(isdigit(_frame[1]))
+		id = _frame[1] - '0';
+	else
+		return false;
+
+	switch(_frame[2]){
+		case 'F':
+			steps = SET_FREQUENCY;
+			break;
+		case 'A':
+			steps = SET_PHASE;
+			break;
+		case 'I':
+			steps = SET_STEP;
+			break;
+		case 'M':
+			steps = SET_MODE;
+			break;
+		case 'S':
+			steps = SET_STATE;
+			break;
+		case 'B':
+			steps = SET_SWEEP_START;
+			break;
+		case 'E':
+			steps = SET_SWEEP_END;
+			break;
+		case 'N':
+			steps = SET_SWEEP_STEPS;
+			break;
+		case 'D':
+			steps = SET_SWEEP_DWELL;
+			break;
+		default:
+			return false;
+	}
+
+	bool tenths = steps == SET_FREQUENCY || steps == SET_PHASE || steps == SET_SWEEP_START || steps == SET_SWEEP_END;
+	long value = 0;
+	byte digits = 0;
+	char decimals = -1;	// digits after the point, -1 before it
+	for(byte i = 3; i < _length; i++){
+		char c = _frame[i];
+		if(c == '.' && tenths && decimals < 0){
+			decimals = 0;
+			continue;
+		}
+		if(!isdigit(c) || decimals >= 1 || digits == 9)
+			return false;
+		value = value * 10 + (c - '0');
+		digits++;
+		if(decimals >= 0)
+			decimals++;
+	}
+	if(digits == 0)
+		return false;
+	if(tenths && decimals != 1){
+		if(value > MAX_VALUE / 10)
+			return false;	// nine whole digits would wrap a 32 bit long
+		value *= 10;
+	}
+
+	_value = value;
+	data = EVENT_SET;
+	return true;
+}
+
+// "W<id><shape>[R]", the shape L, G or X to stop
+bool SerialParser::parse_sweep(int &id, int &data, int &steps){
+	if(_length < 3 || _length > 4 || !isdigit(_frame[1]))
+		return false;
+
+	id = _frame[1] - '0';
+	switch(_frame[2]){
+		case 'L':
+			steps = SWEEP_LINEAR;
+			break;
+		case 'G':
+			steps = SWEEP_LOG;
+			break;
+		case 'X':
+			steps = SWEEP_STOP;
+			break;
+		default:
+			return false;
+	}
+	if(_length == 4){
+		if(_frame[3] != 'R' || steps == SWEEP_STOP)
+			return false;
+		steps += SWEEP_REPEAT;
+	}
+
+	data = EVENT_SWEEP;
+	return true;
+}
+
+// link frames carry encoder events and latency reports
+bool SerialParser::parse_link(int &id, int &data, int &steps){
+	id = _link.id();
+	_last_sequence = _link.sequence();
+	switch(_link.type()){
+		case LINK_TURN:
+			steps = _link.value();
+			data = steps == -1 ? EVENT_DECREMENT : (steps == 1 ? EVENT_INCREMENT : EVENT_DELTA);
+			break;
+		case LINK_PRESS:
+			data = EVENT_PRESS;
+			steps = 0;
+			break;
+		case LINK_REPEAT:
+			data = EVENT_REPEAT;
+			steps = 0;
+			break;
+		case LINK_LATENCY:
+			id = _last_sequence;
+			data = EVENT_LATENCY;
+			steps = (byte)_link.value() * LINK_LATENCY_UNIT_US;
+			break;
+		default:
+			_malformed_count++;
+			return false;
+	}
+	return true;
+}
+
+unsigned int SerialParser::malformed_count(){
+	return _malformed_count;
+}
+
+unsigned int SerialParser::overflowed_count(){
+	return _overflowed_count;
+}
+
+int SerialParser::last_sequence(){
+	return _last_sequence;
+}
+
+unsigned long SerialParser::received_time(){
+	return _received_time;
+}
+
+long SerialParser::value(){
+	return _value;
+}
+
+// sequence and CRC counters for the binary frames
+LinkReceiver *SerialParser::link(){
+	return &_link;
+}
+
+void SerialParser::reset_counts(){
+	_malformed_count = 0;
+	_overflowed_count = 0;
+	_link.reset_counts();
+}
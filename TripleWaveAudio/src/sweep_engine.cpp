@@ -0,0 +1,221 @@
+#include <SPI.h>
+#include "lcd_buffer.h"
+#include "led_handler.h"
+#include "ad9833_driver.h"
+#include "generator_handler.h"
+#include "sweep_engine.h"
+
+#ifdef __AVR__
+static SweepEngine *timer_engine = NULL;
+
+ISR(TIMER1_COMPA_vect){
+	timer_engine->tick();
+}
+#endif
+
+SweepEngine::SweepEngine(){
+	for(byte i = 0; i < MAX_SWEEPS; i++){
+		_sweeps[i].handler = NULL;
+		_sweeps[i].running = false;
+	}
+	_running = 0;
+	_next_refresh = 0;
+}
+
+// Timer1 in CTC mode at TICK_US, its interrupt only enabled while a sweep runs
+// SPI transactions from loop() hold off the interrupt so the tick never splits a word
+void SweepEngine::begin(){
+	SPI.usingInterrupt(255);
+#ifdef __AVR__
+	timer_engine = this;
+	noInterrupts();
+	TCCR1A = 0;
+	TCCR1B = _BV(WGM12) | _BV(CS11);
+	OCR1A = (F_CPU / 8000000UL) * TICK_US - 1;
+	TCNT1 = 0;
+	interrupts();
+#endif
+}
+
+// frequencies in 1/10 Hz, dwell in microseconds per step
+// returns false if the sweep cannot be run as asked
+bool SweepEngine::start(GeneratorHandler *handler, long start_frequency, long end_frequency, unsigned int steps, unsigned long dwell, byte shape, bool repeat){
+	if(steps == 0 || dwell > MAX_DWELL || start_frequency < 0 || end_frequency < 0 ||
+		start_frequency > GeneratorHandler::MAX_FREQUENCY || end_frequency > GeneratorHandler::MAX_FREQUENCY)
+		return false;
+
+	uint32_t start_word = AD9833Driver::tuning_word(start_frequency);
+	uint32_t end_word = AD9833Driver::tuning_word(end_frequency);
+
+	// one float calculation here, none per step; the ratio has to stay below 16
+	uint32_t ratio = 0;
+	if(shape == SHAPE_LOG){
+		if(start_word == 0 || end_word == 0)
+			return false;
+		float step_ratio = pow((float)end_word / start_word, 1.0 / steps);
+		if(step_ratio >= 16.0)
+			return false;
+		ratio = (uint32_t)(step_ratio * (float)(1UL << 28) + 0.5);
+	}
+
+	stop(handler);
+
+	Sweep *sweep = NULL;
+	for(byte i = 0; i < MAX_SWEEPS; i++){
+		if(_sweeps[i].handler == NULL){
+			sweep = &_sweeps[i];
+			break;
+		}
+	}
+	if(sweep == NULL)
+		return false;
+
+	int32_t distance = (int32_t)end_word - (int32_t)start_word;
+	sweep->handler = handler;
+	sweep->generator = handler->_generator;
+	sweep->repeat = repeat;
+	sweep->shape = shape;
+	sweep->steps = steps;
+	sweep->step = 0;
+	sweep->dwell = dwell > TICK_US ? dwell / TICK_US : 1;
+	sweep->countdown = sweep->dwell;
+	sweep->start_word = start_word;
+	sweep->end_word = end_word;
+	sweep->end_frequency = end_frequency;
+	sweep->word = start_word;
+	sweep->increment = distance / (int32_t)steps;
+	sweep->remainder = (distance < 0 ? -distance : distance) % steps;
+	sweep->error = 0;
+	sweep->scaled_word = (uint64_t)start_word << 32;
+	sweep->ratio = ratio;
+
+	handler->_sweeping = true;
+	handler->_frequency = start_frequency;
+	handler->_last_set_freq = start_frequency;
+	sweep->generator->set_frequency(sweep->generator->active(), start_word);
+
+	noInterrupts();
+	sweep->running = true;
+	if(_running++ == 0)
+		enable_timer(true);
+	interrupts();
+	return true;
+}
+
+// leaves the generator at the frequency the sweep had reached
+void SweepEngine::stop(GeneratorHandler *handler){
+	for(byte i = 0; i < MAX_SWEEPS; i++){
+		Sweep *sweep = &_sweeps[i];
+		if(sweep->handler != handler)
+			continue;
+
+		noInterrupts();
+		if(sweep->running){
+			sweep->running = false;
+			if(--_running == 0)
+				enable_timer(false);
+		}
+		interrupts();
+		finish(sweep);
+	}
+}
+
+bool SweepEngine::active(GeneratorHandler *handler){
+	for(byte i = 0; i < MAX_SWEEPS; i++){
+		if(_sweeps[i].handler == handler)
+			return true;
+	}
+	return false;
+}
+
+// timer interrupt: count down each sweep's dwell, then one step and one register write
+void SweepEngine::tick(){
+	for(byte i = 0; i < MAX_SWEEPS; i++){
+		Sweep *sweep = &_sweeps[i];
+		if(!sweep->running || --sweep->countdown != 0)
+			continue;
+
+		sweep->countdown = sweep->dwell;
+		advance(sweep);
+		sweep->generator->set_frequency(sweep->generator->active(), sweep->word);
+	}
+}
+
+void SweepEngine::advance(Sweep *sweep){
+	if(sweep->step == sweep->steps){
+		// repeating, back to the start
+		sweep->step = 0;
+		sweep->word = sweep->start_word;
+		sweep->error = 0;
+		sweep->scaled_word = (uint64_t)sweep->start_word << 32;
+		return;
+	}
+
+	if(++sweep->step == sweep->steps){
+		// land exactly on the end frequency
+		sweep->word = sweep->end_word;
+		if(!sweep->repeat){
+			sweep->running = false;
+			if(--_running == 0)
+				enable_timer(false);
+		}
+		return;
+	}
+
+	if(sweep->shape == SHAPE_LINEAR){
+		sweep->word += sweep->increment;
+		sweep->error += sweep->remainder;
+		if(sweep->error >= sweep->steps){
+			sweep->error -= sweep->steps;
+			sweep->word += sweep->end_word < sweep->start_word ? -1 : 1;
+		}
+	} else {
+		// scaled_word * ratio / 2^28, in two 32x32 multiplies
+		uint64_t high = (sweep->scaled_word >> 32) * sweep->ratio;
+		uint64_t low = (sweep->scaled_word & 0xffffffffUL) * sweep->ratio;
+		sweep->scaled_word = (high << 4) + (low >> 28);
+		sweep->word = (uint32_t)(sweep->scaled_word >> 32);
+	}
+}
+
+// from loop(): show sweep progress, and hand finished sweeps back to their handlers
+void SweepEngine::refresh(unsigned long time){
+	if((long)(time - _next_refresh) < 0)
+		return;
+	_next_refresh = time + DISPLAY_INTERVAL;
+
+	for(byte i = 0; i < MAX_SWEEPS; i++){
+		Sweep *sweep = &_sweeps[i];
+		if(sweep->handler == NULL)
+			continue;
+
+		noInterrupts();
+		uint32_t word = sweep->word;
+		bool running = sweep->running;
+		interrupts();
+
+		sweep->handler->_frequency = AD9833Driver::frequency(word);
+		if(!running)
+			finish(sweep);
+	}
+}
+
+void SweepEngine::finish(Sweep *sweep){
+	GeneratorHandler *handler = sweep->handler;
+	if(handler == NULL)
+		return;
+
+	handler->_frequency = sweep->word == sweep->end_word ? sweep->end_frequency : AD9833Driver::frequency(sweep->word);
+	handler->_last_set_freq = handler->_frequency;
+	handler->_sweeping = false;
+	sweep->handler = NULL;
+}
+
+void SweepEngine::enable_timer(bool enable){
+#ifdef __AVR__
+	if(enable)
+		TIMSK1 |= _BV(OCIE1A);
+	else
+		TIMSK1 &= ~_BV(OCIE1A);
+#endif
+}
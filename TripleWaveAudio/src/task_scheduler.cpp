@@ -0,0 +1,90 @@
+#ifdef __AVR__
+#include <avr/sleep.h>
+#endif
+#include "task_scheduler.h"
+
+TaskScheduler::TaskScheduler(){
+	_num_tasks = 0;
+}
+
+// returns the task number for enable() and trigger()
+byte TaskScheduler::add(TaskFunc func, unsigned int period, bool enabled){
+	if(_num_tasks >= MAX_TASKS)
+		return MAX_TASKS;
+
+	Task *task = &_tasks[_num_tasks];
+	task->func = func;
+	task->period = period;
+	task->deadline = millis();
+	task->enabled = enabled;
+	task->triggered = false;
+	task->lateness = 0;
+	return _num_tasks++;
+}
+
+// an enabled periodic task is due straight away
+void TaskScheduler::enable(byte task, bool enabled){
+	if(task >= _num_tasks)
+		return;
+	if(enabled && !_tasks[task].enabled)
+		_tasks[task].deadline = millis();
+	_tasks[task].enabled = enabled;
+}
+
+// runs the task on the next pass regardless of its deadline
+void TaskScheduler::trigger(byte task){
+	if(task < _num_tasks)
+		_tasks[task].triggered = true;
+}
+
+bool TaskScheduler::due(Task *task, unsigned long time){
+	if(!task->enabled)
+		return false;
+	if(task->triggered)
+		return true;
+	return task->period != 0 && (long)(time - task->deadline) >= 0;
+}
+
+// returns false if nothing was due
+bool TaskScheduler::run(unsigned long time){
+	bool ran = false;
+	for(byte i = 0; i < _num_tasks; i++){
+		Task *task = &_tasks[i];
+		if(!due(task, time))
+			continue;
+
+		if(task->period != 0){
+			unsigned long late = (long)(time - task->deadline) > 0 ? time - task->deadline : 0;
+			if(!task->triggered && late > task->lateness)
+				task->lateness = late;
+			task->deadline = time + task->period;
+		}
+		task->triggered = false;
+		task->func(time);
+		ran = true;
+	}
+	return ran;
+}
+
+// idle sleep keeps the timers and the USART running, so the millis() tick,
+// received bytes and the sweep timer all wake it; a byte that lands between the
+// caller's check and sleeping is picked up on the next millis() tick
+void TaskScheduler::idle(){
+#ifdef __AVR__
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	noInterrupts();
+	sleep_enable();
+	interrupts();
+	sleep_cpu();
+	sleep_disable();
+#endif
+}
+
+unsigned long TaskScheduler::lateness(byte task){
+	return task < _num_tasks ? _tasks[task].lateness : 0;
+}
+
+void TaskScheduler::reset_counts(){
+	for(byte i = 0; i < _num_tasks; i++)
+		_tasks[i].lateness = 0;
+}
@@ -0,0 +1,76 @@
+// The fixed-point formatter against sprintf("%ld.%d") as decimalize() used it,
+// right aligned the way the panel fields were padded
+// Run with: pio test -e native -f test_fixed_point
+
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+#include "fixed_point.h"
+
+// MAX_FREQUENCY from generator_handler.h, in 1/10 Hz
+#define MAX_FREQUENCY 125000000L
+#define FIELD_WIDTH 6
+
+static void sprintf_field(long value, char *field, byte width){
+	char text[16];
+	sprintf(text, "%ld.%d", value / 10L, (int)(value % 10L));
+	int length = strlen(text);
+	if(length > width)
+		length = width;
+	sprintf(field, "%*.*s", width, length, text);
+}
+
+void setUp(void){
+}
+
+void tearDown(void){
+}
+
+void test_format_range(void){
+	char expected[FixedPointField::MAX_WIDTH + 1];
+	char field[FixedPointField::MAX_WIDTH + 1];
+	unsigned long mismatches = 0;
+	long first_mismatch = 0;
+	for(long value = 0; value <= MAX_FREQUENCY; value += (value < 200000L ? 1 : 997)){
+		sprintf_field(value, expected, FIELD_WIDTH);
+		format_fixed_point(value, field, FIELD_WIDTH);
+		if(strcmp(expected, field) != 0 && mismatches++ == 0)
+			first_mismatch = value;
+	}
+	if(mismatches)
+		printf("first mismatch at %ld\n", first_mismatch);
+	TEST_ASSERT_EQUAL(0, mismatches);
+}
+
+void test_format_end_points(void){
+	char field[FixedPointField::MAX_WIDTH + 1];
+	format_fixed_point(0, field, FIELD_WIDTH);
+	TEST_ASSERT_EQUAL_STRING("   0.0", field);
+	format_fixed_point(7, field, FIELD_WIDTH);
+	TEST_ASSERT_EQUAL_STRING("   0.7", field);
+	format_fixed_point(3600, field, FIELD_WIDTH - 1);
+	TEST_ASSERT_EQUAL_STRING("360.0", field);
+	format_fixed_point(MAX_FREQUENCY, field, FixedPointField::MAX_WIDTH);
+	TEST_ASSERT_EQUAL_STRING("12500000.0", field);
+	format_fixed_point(-15, field, FIELD_WIDTH);
+	TEST_ASSERT_EQUAL_STRING("  -1.5", field);
+}
+
+void test_field_cache(void){
+	FixedPointField cache;
+	char field[FixedPointField::MAX_WIDTH + 1];
+	TEST_ASSERT_TRUE(cache.render(12345, field, FIELD_WIDTH));
+	TEST_ASSERT_EQUAL_STRING("1234.5", field);
+	TEST_ASSERT_FALSE(cache.render(12345, field, FIELD_WIDTH));
+	TEST_ASSERT_TRUE(cache.render(12346, field, FIELD_WIDTH));
+	cache.invalidate();
+	TEST_ASSERT_TRUE(cache.render(12346, field, FIELD_WIDTH));
+}
+
+int main(int argc, char **argv){
+	UNITY_BEGIN();
+	RUN_TEST(test_format_range);
+	RUN_TEST(test_format_end_points);
+	RUN_TEST(test_field_cache);
+	return UNITY_END();
+}
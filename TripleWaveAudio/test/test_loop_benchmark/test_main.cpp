@@ -0,0 +1,588 @@
+// Feeds scripted encoder events through loop() on the host and reports the
+// cost of the hot path: host events/sec, bus traffic per event and per pass
+// Run with: pio test -e native -v
+
+#include <chrono>
+#include <unity.h>
+#include <SPI.h>
+#include <Wire.h>
+#include <hd44780.h>
+#include <hd44780ioClass/hd44780_I2Cexp.h>
+#include "leds.h"
+#include "lcd_buffer.h"
+#include "ad9833_driver.h"
+#include "serial_parser.h"
+#include <link_frame.h>
+#include "generator_handler.h"
+#include "latency_tracer.h"
+#include "profiler.h"
+#include "sweep_engine.h"
+#include "sequencer.h"
+
+void setup();
+void loop();
+
+extern SerialParser parser;
+extern AD9833Driver AD1, AD2, AD3;
+extern hd44780_I2Cexp lcd;
+#ifdef TRACE_LATENCY
+extern LatencyTracer tracer;
+#endif
+extern GeneratorHandler *handlers[];
+extern Sequencer sequencer;
+extern SweepEngine sweeps;
+extern int first_visible;
+
+#define TRACED_TURNS 100
+#define ENCODER_LATENCY 12	// in LINK_LATENCY_UNIT_US
+#define TRACE_SPACING 10		// ms between traced turns, about the encoder board's coalescing rate for two knobs
+
+// the histograms go to the test output
+class StdoutPrint : public Print
+{
+public:
+	size_t write(uint8_t c){
+		putchar(c);
+		return 1;
+	}
+	using Print::write;
+};
+
+// I2C at the default 100 kHz, 9 clocks per byte
+#define I2C_US_PER_BYTE 90.0
+
+#define NUM_EVENTS 3000
+#define NUM_IDLE_PASSES 100
+#define BURST_SIZE 12
+#define DETENTS_PER_FRAME 12
+#define EVENT_SPACING 2		// ms between frames, a brisk spin on the encoder board
+#define IDLE_TIMEOUT 600000UL
+#define TRANSITIONS 8
+#define RETUNES 200
+#define SEQUENCE_TIME 1000	// ms
+#define RETUNE_SPACING 20	// ms, a test rig retuning 50 times a second
+#define MAX_TRANSITION_SPI_WORDS 10	// frequency and phase staged on three chips, one shared switch-over word
+
+// a knob spin on each generator, a few button presses, then spins back down
+static const char *next_event(int n){
+	static const char *script[] = {
+		"02\r\n", "02\r\n", "02\r\n", "02\r\n", "12\r\n", "12\r\n", "22\r\n", "22\r\n",
+		"01\r\n", "02\r\n", "00\r\n", "10\r\n", "10\r\n", "20\r\n", "11\r\n", "12\r\n",
+		"21\r\n", "22\r\n", "20\r\n", "00\r\n", "00\r\n", "00\r\n", "10\r\n", "20\r\n",
+	};
+	return script[n % (sizeof(script) / sizeof(script[0]))];
+}
+
+static double elapsed_us(std::chrono::steady_clock::time_point start){
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void report(const char *title, int passes, int events, double wall_us){
+	double per = events ? events : passes;
+	printf("\n%s\n", title);
+	printf("  passes %d, events %d, host time %.1f ms\n", passes, events, wall_us / 1000.0);
+	if(events)
+		printf("  host events/sec    %12.0f\n", events / (wall_us / 1000000.0));
+	printf("  host us/pass       %12.2f\n", wall_us / passes);
+	printf("  per %-5s  i2c bytes %7.1f  lcd cmds %6.1f  lcd chars %6.1f\n", events ? "event" : "pass",
+		mock_bus.i2c_bytes / per, mock_bus.lcd_commands / per, mock_bus.lcd_data / per);
+	printf("             spi words %7.1f  pin writes %6.1f  serial rx %6.1f\n",
+		mock_bus.spi_words / per, mock_bus.pin_writes / per, mock_bus.serial_rx / per);
+	printf("  target I2C time/pass %10.1f us\n", (mock_bus.i2c_bytes / (double)passes) * I2C_US_PER_BYTE);
+	printf("  serial timeout stalls/pass %4.2f\n", mock_bus.serial_stalls / (double)passes);
+}
+
+void setUp(void){
+	Serial.clear_input();
+	mock_reset_counters();
+}
+
+void tearDown(void){
+}
+
+void test_event_throughput(void){
+	AD9833Driver *drivers[] = {&AD1, &AD2, &AD3};
+	for(int i = 0; i < 3; i++)
+		drivers[i]->reset_counts();
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for(int i = 0; i < NUM_EVENTS; i++){
+		Serial.inject(next_event(i));
+		loop();
+		mock_advance_time(EVENT_SPACING);
+	}
+	double wall_us = elapsed_us(start);
+
+	report("loop() with one event per pass", NUM_EVENTS, NUM_EVENTS, wall_us);
+	unsigned long issued = 0, suppressed = 0;
+	for(int i = 0; i < 3; i++){
+		issued += drivers[i]->words_issued();
+		suppressed += drivers[i]->words_suppressed();
+	}
+	printf("  AD9833 words issued %lu, suppressed by the register shadow %lu\n", issued, suppressed);
+	TEST_ASSERT_EQUAL(0, Serial.available());
+	TEST_ASSERT_GREATER_THAN(0, mock_bus.spi_words);
+}
+
+void test_idle_pass(void){
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for(int i = 0; i < NUM_IDLE_PASSES; i++)
+		loop();
+	double wall_us = elapsed_us(start);
+
+	report("loop() with no input", NUM_IDLE_PASSES, 0, wall_us);
+	TEST_ASSERT_EQUAL(0, mock_bus.serial_rx);
+	TEST_ASSERT_EQUAL(0, mock_bus.spi_words);
+}
+
+// the same spins as coalesced frames, costs reported per detent
+void test_coalesced_spin(void){
+	static const char *script[] = {"0+12\r\n", "1+12\r\n", "2+12\r\n", "0-12\r\n", "1-12\r\n", "2-12\r\n"};
+	int frames = NUM_EVENTS / DETENTS_PER_FRAME;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for(int i = 0; i < frames; i++){
+		Serial.inject(script[i % 6]);
+		loop();
+		mock_advance_time(EVENT_SPACING);
+	}
+	double wall_us = elapsed_us(start);
+
+	report("loop() with coalesced frames, per detent", frames, frames * DETENTS_PER_FRAME, wall_us);
+	TEST_ASSERT_EQUAL(0, Serial.available());
+	TEST_ASSERT_EQUAL(0, parser.malformed_count());
+}
+
+// a burst that fits the ring is handled in one pass, a split frame waits for its tail without stalling
+void test_burst_and_partial_frame(void){
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for(int i = 0; i < BURST_SIZE; i++)
+		Serial.inject(next_event(i));
+	Serial.inject("1");
+	loop();
+	double wall_us = elapsed_us(start);
+
+	report("loop() with a burst of events in one pass", 1, BURST_SIZE, wall_us);
+	TEST_ASSERT_EQUAL(0, Serial.available());
+	TEST_ASSERT_EQUAL(0, mock_bus.serial_stalls);
+
+	parser.reset_counts();
+	Serial.inject("2\r\n9\r\n12345678901234\r\n");
+	loop();
+	TEST_ASSERT_EQUAL(1, parser.malformed_count());
+	TEST_ASSERT_EQUAL(1, parser.overflowed_count());
+}
+
+// the coalesced spins again as binary link frames, then a lost frame, a corrupted
+// frame and a text frame for id 3 that must not reach the reset
+void test_link_frames(void){
+	static const int8_t script[] = {12, 12, 12, -12, -12, -12};
+	int frames = NUM_EVENTS / DETENTS_PER_FRAME;
+	byte frame[LINK_FRAME_SIZE];
+	LinkReceiver *link = parser.link();
+	parser.reset_counts();
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for(int i = 0; i < frames; i++){
+		link_encode(frame, LINK_TURN, i % 3, script[i % 6], i);
+		Serial.inject(frame, LINK_FRAME_SIZE);
+		loop();
+		mock_advance_time(EVENT_SPACING);
+	}
+	double wall_us = elapsed_us(start);
+
+	report("loop() with link frames, per detent", frames, frames * DETENTS_PER_FRAME, wall_us);
+	TEST_ASSERT_EQUAL(frames, link->frame_count());
+	TEST_ASSERT_EQUAL(0, link->lost_count());
+	TEST_ASSERT_EQUAL(0, link->crc_error_count());
+
+	link_encode(frame, LINK_TURN, 0, 1, frames + 1);
+	Serial.inject(frame, LINK_FRAME_SIZE);
+	link_encode(frame, LINK_TURN, 0, 1, frames + 2);
+	frame[2] ^= 0x10;
+	Serial.inject(frame, LINK_FRAME_SIZE);
+	Serial.inject("31\r\n");
+	loop();
+	TEST_ASSERT_EQUAL(1, link->lost_count());
+	TEST_ASSERT_EQUAL(1, link->crc_error_count());
+	TEST_ASSERT_EQUAL(1, parser.malformed_count());
+}
+
+// turns followed by latency frames, as sent by an encoder board built with TRACE_LATENCY,
+// the native env builds the tracer in too
+void test_latency_trace(void){
+#ifdef TRACE_LATENCY
+	byte frame[LINK_FRAME_SIZE];
+	tracer.reset();
+
+	for(int i = 0; i < TRACED_TURNS; i++){
+		link_encode(frame, LINK_TURN, i % 3, i & 1 ? 3 : -3, i);
+		Serial.inject(frame, LINK_FRAME_SIZE);
+		link_encode(frame, LINK_LATENCY, i % 3, ENCODER_LATENCY, i);
+		Serial.inject(frame, LINK_FRAME_SIZE);
+		loop();
+		mock_advance_time(TRACE_SPACING);
+	}
+	mock_advance_time(100);
+	loop();
+
+	StdoutPrint out;
+	printf("\nlatency histograms\n");
+	tracer.dump(&out);
+
+	unsigned int encoder = 0, total = 0, display = 0;
+	for(byte bucket = 0; bucket < LatencyTracer::NUM_BUCKETS; bucket++){
+		encoder += tracer.count(LatencyTracer::STAGE_ENCODER, bucket);
+		display += tracer.count(LatencyTracer::STAGE_DISPLAY, bucket);
+		total += tracer.count(LatencyTracer::STAGE_TOTAL, bucket);
+	}
+	TEST_ASSERT_EQUAL(TRACED_TURNS, encoder);
+	TEST_ASSERT_EQUAL(TRACED_TURNS, display);
+	TEST_ASSERT_EQUAL(TRACED_TURNS, total);
+	// 1200 us lands in the bucket below 2048
+	TEST_ASSERT_EQUAL(TRACED_TURNS, tracer.count(LatencyTracer::STAGE_ENCODER, 5));
+#else
+	TEST_IGNORE_MESSAGE("built without TRACE_LATENCY");
+#endif
+}
+
+// the section table after a spin, the native env builds with PROFILE_SECTIONS
+void test_profile_table(void){
+#ifdef PROFILE_SECTIONS
+	profiler_reset();
+	for(int i = 0; i < NUM_EVENTS / 10; i++){
+		Serial.inject(next_event(i));
+		loop();
+		mock_advance_time(EVENT_SPACING);
+	}
+
+	StdoutPrint out;
+	printf("\nsection count min max total (host us)\n");
+	profiler_dump(&out);
+#else
+	TEST_IGNORE_MESSAGE("built without PROFILE_SECTIONS");
+#endif
+}
+
+// presses on generator A step every generator round normal, solo, sync and muted,
+// each transition should cost one batched generator update and one render pass
+void test_state_transitions(void){
+	mock_advance_time(EVENT_SPACING * 20);
+	loop();
+
+	printf("\nbus operations per button transition\n");
+	for(int i = 0; i < TRANSITIONS; i++){
+		mock_reset_counters();
+		Serial.inject("01\r\n");
+		loop();
+		mock_advance_time(EVENT_SPACING * 20);
+		loop();
+		printf("  press %d  spi words %3lu  lcd cmds %3lu  lcd chars %3lu  i2c bytes %4lu  pin writes %lu\n",
+			i, mock_bus.spi_words, mock_bus.lcd_commands, mock_bus.lcd_data, mock_bus.i2c_bytes, mock_bus.pin_writes);
+		TEST_ASSERT_LESS_OR_EQUAL(MAX_TRANSITION_SPI_WORDS, mock_bus.spi_words);
+	}
+}
+
+// a host retunes all three generators per bulk, each bulk should land as one
+// batched update whichever passes its frames arrive in
+void test_bulk_retune(void){
+	char frame[20];
+	GeneratorSettings settings;
+	unsigned long max_words = 0;
+
+	Serial.inject("=*S0\r\n");
+	loop();
+	mock_advance_time(RETUNE_SPACING);
+	loop();
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for(int i = 0; i < RETUNES; i++){
+		unsigned long words = mock_bus.spi_words;
+		Serial.inject("[\r\n");
+		for(int g = 0; g < 3; g++){
+			sprintf(frame, "=%dF%ld.%d\r\n", g, 1000L + i * 3 + g, g);
+			Serial.inject(frame);
+			if(i == 0 && g == 0)
+				Serial.inject("=1M4\r\n");	// triangle, set by its switch-over word
+			if(g == 1){
+				// the rest of the bulk comes a pass later, nothing may go out before it
+				loop();
+				TEST_ASSERT_EQUAL(words, mock_bus.spi_words);
+			}
+		}
+		Serial.inject("]\r\n");
+		SPI.log_count = 0;
+		loop();
+		if(i == 0){
+			// chips 0 and 2 switch over on one control word, chip 1 in its new mode on another
+			int controls = 0;
+			for(int w = 0; w < SPI.log_count; w++){
+				if(SPI.log[w] & (AD9833_FREQ0 | AD9833_FREQ1))
+					continue;
+				TEST_ASSERT_FALSE(SPI.log[w] & AD9833_RESET);
+				controls++;
+			}
+			TEST_ASSERT_EQUAL(2, controls);
+			TEST_ASSERT_EQUAL_HEX16(AD9833_B28 | AD9833Driver::mode_bits(AD9833Driver::MODE_TRIANGLE),
+				SPI.log[SPI.log_count - 1] & ~AD9833_SELECT);
+		}
+		if(mock_bus.spi_words - words > max_words)
+			max_words = mock_bus.spi_words - words;
+		mock_advance_time(RETUNE_SPACING);
+	}
+	double wall_us = elapsed_us(start);
+
+	report("bulk retunes of three generators", RETUNES, RETUNES, wall_us);
+	printf("  most spi words for one bulk %lu\n", max_words);
+	TEST_ASSERT_LESS_OR_EQUAL(MAX_TRANSITION_SPI_WORDS, max_words);
+	for(int g = 0; g < 3; g++){
+		handlers[g]->save_settings(&settings);
+		TEST_ASSERT_EQUAL(10000L + (RETUNES - 1) * 30 + g * 11, settings.frequency);
+	}
+
+	TEST_ASSERT_GREATER_THAN(0, mock_bus.lcd_data);
+
+	// out of range is ignored, then all muted again for the tests after
+	Serial.inject("=0F125000000.1\r\n=*S1\r\n=1M2\r\n");
+	loop();
+	handlers[0]->save_settings(&settings);
+	TEST_ASSERT_EQUAL(10000L + (RETUNES - 1) * 30, settings.frequency);
+
+	// nine whole digits scaled to tenths would wrap a 32 bit long into range
+	unsigned int malformed = parser.malformed_count();
+	int phase = settings.phase;
+	Serial.inject("=0A429496730\r\n=0F429496800\r\n=0I429496730\r\n");
+	loop();
+	TEST_ASSERT_EQUAL(malformed + 2, parser.malformed_count());
+	handlers[0]->save_settings(&settings);
+	TEST_ASSERT_EQUAL(10000L + (RETUNES - 1) * 30, settings.frequency);
+	TEST_ASSERT_EQUAL(phase, settings.phase);
+	TEST_ASSERT_EQUAL(GeneratorHandler::STATE_MUTED, settings.state);
+	mock_advance_time(RETUNE_SPACING * 2);
+	loop();
+}
+
+// the timer interrupt of the target, one call per tick over ms milliseconds with loop()
+// running every EVENT_SPACING ms meanwhile
+static void run_ticks(unsigned long ms){
+	for(unsigned long t = 0; t < ms; t++){
+		for(unsigned int i = 0; i < 1000 / SweepEngine::TICK_US; i++){
+			sweeps.tick();
+			sequencer.tick();
+		}
+		mock_advance_time(1);
+		if(t % EVENT_SPACING == 0)
+			loop();
+	}
+}
+
+// tone bursts of 10 ms every 100 ms: each boundary is one register write of two words,
+// then the chord sequence runs once and hands the generators back muted
+void test_sequencer(void){
+	GeneratorSettings settings;
+	Serial.inject("Q3\r\n");
+	loop();
+	TEST_ASSERT_TRUE(sequencer.running());
+
+	mock_reset_counters();
+	run_ticks(SEQUENCE_TIME);
+	printf("\nsequencer over %d ms: spi words %lu, lcd chars %lu\n", SEQUENCE_TIME, mock_bus.spi_words, mock_bus.lcd_data);
+	TEST_ASSERT_EQUAL(2 * SEQUENCE_TIME / 100 * 2, mock_bus.spi_words);
+
+	Serial.inject("Q0\r\n");
+	loop();
+	TEST_ASSERT_FALSE(sequencer.running());
+	handlers[0]->save_settings(&settings);
+	TEST_ASSERT_TRUE(labs(settings.frequency - 10000L) <= 1);
+
+	// a chord is staged on all three chips, then they switch over on the last words
+	Serial.inject("Q2\r\n");
+	loop();
+	SPI.log_count = 0;
+	sequencer.tick();
+	int controls = 0;
+	for(int w = 0; w < SPI.log_count; w++){
+		if(SPI.log[w] & (AD9833_FREQ0 | AD9833_FREQ1))
+			TEST_ASSERT_EQUAL(0, controls);
+		else
+			controls++;
+	}
+	printf("chord boundary: spi words %d, control words %d\n", SPI.log_count, controls);
+	TEST_ASSERT_EQUAL(1, controls);
+	run_ticks(4000);
+	TEST_ASSERT_FALSE(sequencer.running());
+	for(int g = 0; g < 3; g++){
+		handlers[g]->save_settings(&settings);
+		TEST_ASSERT_EQUAL(GeneratorHandler::STATE_MUTED, settings.state);
+	}
+}
+
+// a setting or a knob turn on a generator the sequence plays ends the sequence and stands,
+// input to the other generators leaves it playing
+void test_sequence_input(void){
+	GeneratorSettings settings;
+	Serial.inject("Q1\r\n");
+	loop();
+	run_ticks(300);
+	Serial.inject("=1F5000\r\n");
+	loop();
+	TEST_ASSERT_TRUE(sequencer.running());
+
+	Serial.inject("=0F5000\r\n");
+	loop();
+	run_ticks(600);
+	TEST_ASSERT_FALSE(sequencer.running());
+	handlers[0]->save_settings(&settings);
+	TEST_ASSERT_EQUAL(50000L, settings.frequency);
+
+	Serial.inject("Q1\r\n");
+	loop();
+	run_ticks(300);
+	TEST_ASSERT_TRUE(sequencer.running());
+	handlers[0]->save_settings(&settings);
+	long frequency = settings.frequency;
+	Serial.inject("0+1\r\n");
+	loop();
+	run_ticks(600);
+	TEST_ASSERT_FALSE(sequencer.running());
+	handlers[0]->save_settings(&settings);
+	TEST_ASSERT_TRUE(settings.frequency != frequency);
+	TEST_ASSERT_TRUE(labs(settings.frequency - frequency) <= 10000L);
+
+	Serial.inject("=*S1\r\n");
+	loop();
+}
+
+// a sweep set up and started from the host: once through lands on the end frequency,
+// a repeating one runs until stopped
+void test_sweep_command(void){
+	GeneratorSettings settings;
+	unsigned int malformed = parser.malformed_count();
+	Serial.inject("=0B1000\r\n=0E2000\r\n=0N10\r\n=0D1000\r\nW0L\r\n");
+	loop();
+	TEST_ASSERT_TRUE(sweeps.active(handlers[0]));
+
+	run_ticks(SweepEngine::DISPLAY_INTERVAL + 20);
+	TEST_ASSERT_FALSE(sweeps.active(handlers[0]));
+	handlers[0]->save_settings(&settings);
+	TEST_ASSERT_EQUAL(20000L, settings.frequency);
+
+	Serial.inject("W0GR\r\n");
+	loop();
+	run_ticks(SEQUENCE_TIME);
+	TEST_ASSERT_TRUE(sweeps.active(handlers[0]));
+	Serial.inject("W0X\r\nW0XR\r\nW0Q\r\n");
+	loop();
+	TEST_ASSERT_FALSE(sweeps.active(handlers[0]));
+	TEST_ASSERT_EQUAL(malformed + 2, parser.malformed_count());
+}
+
+// redraws with the LED states unchanged leave the LED pins alone
+void test_led_redraw(void){
+	Serial.inject("0+1\r\n");
+	loop();
+	mock_advance_time(EVENT_SPACING * 20);
+	mock_reset_counters();
+
+	for(int i = 0; i < NUM_IDLE_PASSES; i++){
+		Serial.inject(i & 1 ? "1+1\r\n" : "1-1\r\n");
+		loop();
+		mock_advance_time(EVENT_SPACING * 20);
+	}
+	printf("\nredraws with unchanged LED states: pin writes %lu\n", mock_bus.pin_writes);
+	TEST_ASSERT_GREATER_THAN(0, mock_bus.lcd_data);
+	TEST_ASSERT_EQUAL(0, mock_bus.pin_writes);
+}
+
+// a generator's LED follows its state while the panel is scrolled past it; with three
+// generators there is nothing to scroll and the LED simply follows
+void test_scrolled_leds(void){
+	byte frame[LINK_FRAME_SIZE];
+	int sequence = parser.link()->frame_count();
+	link_encode(frame, LINK_TURN, 3, 1, sequence++);
+	Serial.inject(frame, LINK_FRAME_SIZE);
+	Serial.inject("=0S0\r\n");
+	loop();
+	mock_advance_time(EVENT_SPACING * 20);
+	loop();
+	TEST_ASSERT_EQUAL(HIGH, digitalRead(GREEN_PANEL_LED));
+
+	Serial.inject("=0S1\r\n");
+	loop();
+	mock_advance_time(EVENT_SPACING * 20);
+	loop();
+	TEST_ASSERT_EQUAL(LOW, digitalRead(GREEN_PANEL_LED));
+
+	link_encode(frame, LINK_TURN, 3, -1, sequence++);
+	Serial.inject(frame, LINK_FRAME_SIZE);
+	loop();
+	TEST_ASSERT_EQUAL(0, first_visible);
+}
+
+// event digits beyond the encoder events are not commands: a stray "05" recalls no preset,
+// "16" stores none and "09" does not apply the last setting again
+void test_event_digits(void){
+	GeneratorSettings before[3], after;
+	Serial.inject("=1F12345\r\n");
+	loop();
+	for(int g = 0; g < 3; g++)
+		handlers[g]->save_settings(&before[g]);
+
+	unsigned int malformed = parser.malformed_count();
+	Serial.inject("05\r\n16\r\n09\r\n");
+	loop();
+	mock_advance_time(EVENT_SPACING * 20);
+	loop();
+	TEST_ASSERT_EQUAL(malformed + 3, parser.malformed_count());
+	for(int g = 0; g < 3; g++){
+		handlers[g]->save_settings(&after);
+		TEST_ASSERT_EQUAL(before[g].frequency, after.frequency);
+		TEST_ASSERT_EQUAL(before[g].phase, after.phase);
+		TEST_ASSERT_EQUAL(before[g].state, after.state);
+	}
+}
+
+// the display goes dark after the idle timeout and any frame brings it back,
+// the panel LEDs animate from the timer tick meanwhile
+void test_idle_timeout(void){
+	loop();
+	TEST_ASSERT_TRUE(lcd.is_on());
+
+	mock_advance_time(IDLE_TIMEOUT + 1000);
+	loop();
+	TEST_ASSERT_FALSE(lcd.is_on());
+
+	mock_reset_counters();
+	for(int i = 0; i < NUM_IDLE_PASSES; i++){
+		panel_leds.tick();
+		mock_advance_time(10);
+	}
+	TEST_ASSERT_GREATER_THAN(0, mock_bus.pin_writes);
+
+	Serial.inject("0+1\r\n");
+	loop();
+	TEST_ASSERT_TRUE(lcd.is_on());
+}
+
+int main(int argc, char **argv){
+	setup();
+
+	UNITY_BEGIN();
+	RUN_TEST(test_event_throughput);
+	RUN_TEST(test_idle_pass);
+	RUN_TEST(test_coalesced_spin);
+	RUN_TEST(test_burst_and_partial_frame);
+	RUN_TEST(test_link_frames);
+	RUN_TEST(test_latency_trace);
+	RUN_TEST(test_profile_table);
+	RUN_TEST(test_state_transitions);
+	RUN_TEST(test_bulk_retune);
+	RUN_TEST(test_sequencer);
+	RUN_TEST(test_sequence_input);
+	RUN_TEST(test_sweep_command);
+	RUN_TEST(test_led_redraw);
+	RUN_TEST(test_scrolled_leds);
+	RUN_TEST(test_event_digits);
+	RUN_TEST(test_idle_timeout);
+	return UNITY_END();
+}
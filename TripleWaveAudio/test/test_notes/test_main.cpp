@@ -0,0 +1,136 @@
+// The compile-time note tables against equal temperament in double precision,
+// and stepping a generator by semitone
+// Run with: pio test -e native -f test_notes
+
+#include <math.h>
+#include <string.h>
+#include <unity.h>
+#include "notes.h"
+#include "progmem.h"
+#include "generator_handler.h"
+
+extern GeneratorHandler *handlers[];
+
+#define FIELD_WIDTH 6
+
+static long pow_frequency(int note, long a4){
+	return lround(a4 * pow(2.0, (note - NOTE_A4_INDEX) / 12.0));
+}
+
+static long frequency_of(GeneratorHandler *handler){
+	GeneratorSettings settings;
+	handler->save_settings(&settings);
+	return settings.frequency;
+}
+
+void setUp(void){
+}
+
+void tearDown(void){
+}
+
+void test_frequency_table(void){
+	for(int note = 0; note < NUM_NOTES; note++){
+		TEST_ASSERT_EQUAL(pow_frequency(note, NOTE_A4), progmem_read(&note_frequencies[note]));
+		TEST_ASSERT_EQUAL_UINT32(AD9833Driver::tuning_word(note_frequency(note)), progmem_read(&note_words[note]));
+	}
+	// the portable presets
+	TEST_ASSERT_EQUAL(5233L, note_frequency(note_index(NOTE_C, 5), 4400L));
+	TEST_ASSERT_EQUAL(6593L, note_frequency(note_index(NOTE_E, 5), 4400L));
+	TEST_ASSERT_EQUAL(7840L, note_frequency(note_index(NOTE_G, 5), 4400L));
+}
+
+// every reference NOTE_A4 accepts, in 1/10 Hz
+void test_references(void){
+	for(long a4 = 4000L; a4 <= 4800L; a4++){
+		for(int note = 0; note < NUM_NOTES; note++)
+			TEST_ASSERT_EQUAL(pow_frequency(note, a4), note_frequency(note, a4));
+	}
+}
+
+void test_lookup(void){
+	int a4 = NOTE_A4_INDEX;
+	long frequency = note_to_frequency(a4);
+	TEST_ASSERT_EQUAL(a4, note_at_or_below(frequency));
+	TEST_ASSERT_EQUAL(a4 - 1, note_at_or_below(frequency - 1));
+	TEST_ASSERT_EQUAL(NO_NOTE, note_at_or_below(note_to_frequency(0) - 1));
+	TEST_ASSERT_EQUAL(NUM_NOTES - 1, note_at_or_below(GeneratorHandler::MAX_FREQUENCY));
+
+	// a quarter tone either side of A4 is about 3% of the frequency
+	TEST_ASSERT_EQUAL(a4, nearest_note(frequency + frequency * 2 / 100));
+	TEST_ASSERT_EQUAL(a4 + 1, nearest_note(frequency + frequency * 4 / 100));
+	TEST_ASSERT_EQUAL(a4, nearest_note(frequency - frequency * 2 / 100));
+	TEST_ASSERT_EQUAL(a4 - 1, nearest_note(frequency - frequency * 4 / 100));
+	TEST_ASSERT_EQUAL(0, nearest_note(0));
+}
+
+void test_format_note(void){
+	char field[FIELD_WIDTH + 1];
+	format_note(NOTE_A4_INDEX, true, field, FIELD_WIDTH);
+	TEST_ASSERT_EQUAL_STRING("    A4", field);
+	format_note(note_index(NOTE_CS, 5), false, field, FIELD_WIDTH);
+	TEST_ASSERT_EQUAL_STRING("  ~C#5", field);
+	format_note(NUM_NOTES - 1, true, field, FIELD_WIDTH);
+	TEST_ASSERT_EQUAL_STRING("    B9", field);
+}
+
+// off a note the first semitone goes to the neighbouring note, then on by whole semitones
+void test_step_note(void){
+	GeneratorHandler *handler = handlers[0];
+	long frequency = note_to_frequency(NOTE_A4_INDEX) + 5;
+	TEST_ASSERT_TRUE(handler->set_frequency(frequency));
+
+	handler->turn(1, GeneratorHandler::EDIT_NOTE);
+	TEST_ASSERT_EQUAL(note_to_frequency(NOTE_A4_INDEX + 1), frequency_of(handler));
+	handler->turn(12, GeneratorHandler::EDIT_NOTE);
+	TEST_ASSERT_EQUAL(note_to_frequency(NOTE_A4_INDEX + 13), frequency_of(handler));
+
+	TEST_ASSERT_TRUE(handler->set_frequency(frequency));
+	handler->turn(-1, GeneratorHandler::EDIT_NOTE);
+	TEST_ASSERT_EQUAL(note_to_frequency(NOTE_A4_INDEX), frequency_of(handler));
+	handler->turn(-NUM_NOTES, GeneratorHandler::EDIT_NOTE);
+	TEST_ASSERT_EQUAL(note_to_frequency(0), frequency_of(handler));
+}
+
+// set onto a note from elsewhere, as by a preset or a host, a step either way leaves it
+void test_step_from_note(void){
+	GeneratorHandler *handler = handlers[0];
+	int c5 = note_index(NOTE_C, 5);
+
+	TEST_ASSERT_TRUE(handler->set_frequency(note_to_frequency(c5)));
+	handler->turn(-1, GeneratorHandler::EDIT_NOTE);
+	TEST_ASSERT_EQUAL(note_to_frequency(c5 - 1), frequency_of(handler));
+
+	TEST_ASSERT_TRUE(handler->set_frequency(note_to_frequency(c5)));
+	handler->turn(1, GeneratorHandler::EDIT_NOTE);
+	TEST_ASSERT_EQUAL(note_to_frequency(c5 + 1), frequency_of(handler));
+}
+
+// a fast spin steps one semitone per detent, only frequency edits speed up
+void test_fast_turns(void){
+	GeneratorHandler *handler = handlers[0];
+	int a4 = NOTE_A4_INDEX;
+	TEST_ASSERT_TRUE(handler->set_frequency(note_to_frequency(a4)));
+	for(int i = 1; i <= 4; i++){
+		handler->turn(1, GeneratorHandler::EDIT_NOTE);
+		TEST_ASSERT_EQUAL(note_to_frequency(a4 + i), frequency_of(handler));
+	}
+
+	TEST_ASSERT_TRUE(handler->set_step(0));
+	long frequency = frequency_of(handler);
+	handler->turn(1, GeneratorHandler::EDIT_FREQUENCY);
+	handler->turn(1, GeneratorHandler::EDIT_FREQUENCY);
+	TEST_ASSERT_TRUE(frequency_of(handler) > frequency + 2);
+}
+
+int main(int argc, char **argv){
+	UNITY_BEGIN();
+	RUN_TEST(test_frequency_table);
+	RUN_TEST(test_references);
+	RUN_TEST(test_lookup);
+	RUN_TEST(test_format_note);
+	RUN_TEST(test_step_note);
+	RUN_TEST(test_step_from_note);
+	RUN_TEST(test_fast_turns);
+	return UNITY_END();
+}
@@ -0,0 +1,128 @@
+// The tuning words a sweep writes on each tick of the timer, against the same
+// steps worked out independently in 64 and 128 bit arithmetic
+// Run with: pio test -e native -f test_sweep_engine
+
+#include <math.h>
+#include <unity.h>
+#include <SPI.h>
+#include "ad9833_driver.h"
+#include "generator_handler.h"
+#include "sweep_engine.h"
+
+extern GeneratorHandler *handlers[];
+
+#define NO_WRITE 0xffffffffUL
+
+static SweepEngine engine;
+static unsigned long refresh_time = 0;
+
+// the frequency register word one tick wrote as its two halves, NO_WRITE if it wrote none
+static uint32_t tick_word(){
+	SPI.log_count = 0;
+	engine.tick();
+	if(SPI.log_count == 0)
+		return NO_WRITE;
+	return (SPI.log[0] & 0x3fff) | ((uint32_t)(SPI.log[1] & 0x3fff) << 14);
+}
+
+// whole steps in a straight line, the remainders spread evenly
+static uint32_t linear_word(uint32_t start, uint32_t end, unsigned int step, unsigned int steps){
+	if(end >= start)
+		return start + (uint32_t)((uint64_t)(end - start) * step / steps);
+	return start - (uint32_t)((uint64_t)(start - end) * step / steps);
+}
+
+static void check_linear(long start_frequency, long end_frequency, unsigned int steps){
+	GeneratorHandler *handler = handlers[0];
+	uint32_t start = AD9833Driver::tuning_word(start_frequency);
+	uint32_t end = AD9833Driver::tuning_word(end_frequency);
+
+	TEST_ASSERT_TRUE(engine.start(handler, start_frequency, end_frequency, steps, SweepEngine::TICK_US, SweepEngine::SHAPE_LINEAR));
+	for(unsigned int step = 1; step < steps; step++)
+		TEST_ASSERT_EQUAL_UINT32(linear_word(start, end, step, steps), tick_word());
+	TEST_ASSERT_EQUAL_UINT32(end, tick_word());
+
+	// once through, then the generator is handed back at the end frequency
+	TEST_ASSERT_EQUAL_UINT32(NO_WRITE, tick_word());
+	engine.refresh(refresh_time += SweepEngine::DISPLAY_INTERVAL);
+	TEST_ASSERT_FALSE(engine.active(handler));
+	GeneratorSettings settings;
+	handler->save_settings(&settings);
+	TEST_ASSERT_EQUAL(end_frequency, settings.frequency);
+}
+
+void setUp(void){
+}
+
+void tearDown(void){
+	engine.stop(handlers[0]);
+}
+
+void test_linear_up(void){
+	check_linear(10000L, 20000L, 7);
+}
+
+void test_linear_down(void){
+	check_linear(200000L, 2000L, 13);
+}
+
+// each step multiplies the word, scaled by 2^32, by the ratio scaled by 2^28
+void test_log(void){
+	GeneratorHandler *handler = handlers[0];
+	const long start_frequency = 1000L;
+	const long end_frequency = 100000L;
+	const unsigned int steps = 10;
+	uint32_t start = AD9833Driver::tuning_word(start_frequency);
+	uint32_t end = AD9833Driver::tuning_word(end_frequency);
+	uint32_t ratio = (uint32_t)(pow((float)end / start, 1.0 / steps) * (float)(1UL << 28) + 0.5);
+
+	TEST_ASSERT_TRUE(engine.start(handler, start_frequency, end_frequency, steps, SweepEngine::TICK_US, SweepEngine::SHAPE_LOG));
+	unsigned __int128 scaled = (unsigned __int128)start << 32;
+	for(unsigned int step = 1; step < steps; step++){
+		scaled = (scaled * ratio) >> 28;
+		uint32_t word = tick_word();
+		TEST_ASSERT_EQUAL_UINT32((uint32_t)(scaled >> 32), word);
+		// and on the curve from start to end, within a count and 0.01%
+		double ideal = start * pow((double)end / start, (double)step / steps);
+		TEST_ASSERT_TRUE(fabs(word - ideal) <= 1 + ideal / 10000);
+	}
+	TEST_ASSERT_EQUAL_UINT32(end, tick_word());
+}
+
+// a repeating sweep writes the start word after the end word and goes round again
+void test_repeat(void){
+	GeneratorHandler *handler = handlers[0];
+	const unsigned int steps = 5;
+	uint32_t start = AD9833Driver::tuning_word(5000L);
+	uint32_t end = AD9833Driver::tuning_word(6000L);
+
+	TEST_ASSERT_TRUE(engine.start(handler, 5000L, 6000L, steps, SweepEngine::TICK_US, SweepEngine::SHAPE_LINEAR, true));
+	for(int round = 0; round < 3; round++){
+		for(unsigned int step = 1; step < steps; step++)
+			TEST_ASSERT_EQUAL_UINT32(linear_word(start, end, step, steps), tick_word());
+		TEST_ASSERT_EQUAL_UINT32(end, tick_word());
+		TEST_ASSERT_EQUAL_UINT32(start, tick_word());
+	}
+	TEST_ASSERT_TRUE(engine.active(handler));
+}
+
+// the dwell counts down in ticks, a step only every dwell / TICK_US of them
+void test_dwell(void){
+	const unsigned int dwell_ticks = 4;
+	TEST_ASSERT_TRUE(engine.start(handlers[0], 10000L, 20000L, 2, dwell_ticks * SweepEngine::TICK_US, SweepEngine::SHAPE_LINEAR));
+	for(unsigned int i = 1; i < dwell_ticks; i++)
+		TEST_ASSERT_EQUAL_UINT32(NO_WRITE, tick_word());
+	TEST_ASSERT_TRUE(tick_word() != NO_WRITE);
+
+	TEST_ASSERT_FALSE(engine.start(handlers[0], 10000L, 20000L, 2, SweepEngine::MAX_DWELL + 1, SweepEngine::SHAPE_LINEAR));
+}
+
+int main(int argc, char **argv){
+	UNITY_BEGIN();
+	RUN_TEST(test_linear_up);
+	RUN_TEST(test_linear_down);
+	RUN_TEST(test_log);
+	RUN_TEST(test_repeat);
+	RUN_TEST(test_dwell);
+	return UNITY_END();
+}
@@ -0,0 +1,98 @@
+// The integer tuning and phase words against the float formulas of the
+// MD_AD9833 library, evaluated in double precision
+// Run with: pio test -e native -f test_tuning_word
+
+#include <unity.h>
+#include <SPI.h>
+#include "ad9833_driver.h"
+
+// MAX_FREQUENCY from generator_handler.h, in 1/10 Hz
+#define MAX_FREQUENCY 125000000UL
+#define MAX_PHASE 3600
+
+static uint32_t float_tuning_word(unsigned long frequency){
+	return (uint32_t)(((frequency / 10.0) * (double)(1UL << 28) / AD9833_MCLK) + 0.5);
+}
+
+static uint16_t float_phase_word(unsigned int phase){
+	return (uint16_t)((512.0 * (phase / 10.0) / 45) + 0.5) & 0x0fff;
+}
+
+void setUp(void){
+}
+
+void tearDown(void){
+}
+
+void test_tuning_word_full_range(void){
+	unsigned long mismatches = 0;
+	unsigned long first_mismatch = 0;
+	for(unsigned long frequency = 0; frequency <= MAX_FREQUENCY; frequency++){
+		if(AD9833Driver::tuning_word(frequency) != float_tuning_word(frequency)){
+			if(mismatches++ == 0)
+				first_mismatch = frequency;
+		}
+	}
+	if(mismatches)
+		printf("first mismatch at %lu tenths: %lu vs %lu\n", first_mismatch,
+			(unsigned long)AD9833Driver::tuning_word(first_mismatch), (unsigned long)float_tuning_word(first_mismatch));
+	TEST_ASSERT_EQUAL(0, mismatches);
+}
+
+void test_tuning_word_end_points(void){
+	TEST_ASSERT_EQUAL_UINT32(0, AD9833Driver::tuning_word(0));
+	// 1 Hz is 10.737 counts
+	TEST_ASSERT_EQUAL_UINT32(11, AD9833Driver::tuning_word(10));
+	// MCLK / 2 is 2^27
+	TEST_ASSERT_EQUAL_UINT32(1UL << 27, AD9833Driver::tuning_word(MAX_FREQUENCY));
+}
+
+void test_phase_word_full_range(void){
+	for(unsigned int phase = 0; phase <= MAX_PHASE; phase++)
+		TEST_ASSERT_EQUAL_UINT16(float_phase_word(phase), AD9833Driver::phase_word(phase));
+}
+
+// LSB half then MSB half, both addressed to FREQ0
+void test_set_frequency_words(void){
+	AD9833Driver driver(10);
+	uint32_t word = AD9833Driver::tuning_word(12345678UL);
+
+	SPI.log_count = 0;
+	driver.set_frequency(0, word);
+	TEST_ASSERT_EQUAL(2, SPI.log_count);
+	TEST_ASSERT_EQUAL_HEX16(AD9833_FREQ0 | (word & 0x3fff), SPI.log[0]);
+	TEST_ASSERT_EQUAL_HEX16(AD9833_FREQ0 | ((word >> 14) & 0x3fff), SPI.log[1]);
+}
+
+// three chips held in reset and loaded, then all let go by one control word
+void test_coherent_restart(void){
+	AD9833Driver a(10), b(9), c(8);
+	AD9833Driver *drivers[] = {&a, &b, &c};
+	for(int i = 0; i < 3; i++)
+		drivers[i]->begin(AD9833Driver::MODE_SINE);
+
+	SPI.log_count = 0;
+	for(int i = 0; i < 3; i++){
+		int start = SPI.log_count;
+		drivers[i]->hold(AD9833Driver::MODE_SINE);
+		drivers[i]->set_frequency(drivers[i]->active(), AD9833Driver::tuning_word(10000UL));
+		drivers[i]->set_phase(drivers[i]->active(), AD9833Driver::phase_word(i * 1200));
+		TEST_ASSERT_TRUE(SPI.log[start] & AD9833_RESET);
+	}
+	int loaded = SPI.log_count;
+	AD9833Driver::release(drivers, 3);
+	TEST_ASSERT_EQUAL(loaded + 1, SPI.log_count);
+	TEST_ASSERT_EQUAL_HEX16(AD9833_B28 | AD9833Driver::mode_bits(AD9833Driver::MODE_SINE), SPI.log[SPI.log_count - 1]);
+	for(int i = 0; i < 3; i++)
+		TEST_ASSERT_EQUAL(0, drivers[i]->active());
+}
+
+int main(int argc, char **argv){
+	UNITY_BEGIN();
+	RUN_TEST(test_tuning_word_full_range);
+	RUN_TEST(test_tuning_word_end_points);
+	RUN_TEST(test_phase_word_full_range);
+	RUN_TEST(test_set_frequency_words);
+	RUN_TEST(test_coherent_restart);
+	return UNITY_END();
+}
@@ -4,10 +4,9 @@
  * This example code is in the public domain.
  */
 
-// #define ENCODER_DO_NOT_USE_INTERRUPTS
 #include <Arduino.h>
-#include <limits.h>
-#include <Encoder.h>
+#include "quadrature_decoder.h"
+#include "tx_queue.h"
 #include "encoder_handler.h"
 
 #define _IDA 1
@@ -24,22 +23,46 @@
 #define DTC 9
 #define SWC 10
 
-#define CLKD 0
-#define DTD 0
+// encoder D when fitted, the decoder needs the data pin on the next bit of the clock's port
+#define CLKD A0
+#define DTD A1
 #define SWD 11
 
 #define PULSES_PER_DETENT 2
 
-EncoderHandler encoder_handlerA(0, CLKA, DTA, SWA, PULSES_PER_DETENT);
-EncoderHandler encoder_handlerB(1, CLKB, DTB, SWB, PULSES_PER_DETENT);
-EncoderHandler encoder_handlerC(2, CLKC, DTC, SWC, PULSES_PER_DETENT);
-EncoderHandler encoder_handlerD(3, CLKD, DTD, SWD, PULSES_PER_DETENT);
+QuadratureDecoder decoder;
+TxQueue tx_queue;
+
+ISR(TIMER2_COMPA_vect){
+  decoder.tick();
+}
+
+ISR(USART_UDRE_vect){
+  tx_queue.drain();
+}
+
+EncoderHandler encoder_handlerA(0, SWA, &tx_queue);
+EncoderHandler encoder_handlerB(1, SWB, &tx_queue);
+EncoderHandler encoder_handlerC(2, SWC, &tx_queue);
+EncoderHandler encoder_handlerD(3, SWD, &tx_queue);
+
+EncoderHandler *encoder_handlers[] = {&encoder_handlerA, &encoder_handlerB, &encoder_handlerC, &encoder_handlerD};
 
 void setup(){
-  Serial.begin(115200);
+  tx_queue.begin(115200);
+
+  decoder.add(0, CLKA, DTA, PULSES_PER_DETENT);
+  decoder.add(1, CLKB, DTB, PULSES_PER_DETENT);
+  decoder.add(2, CLKC, DTC, PULSES_PER_DETENT);
+  decoder.add(3, CLKD, DTD, PULSES_PER_DETENT);
+  decoder.begin();
 }
 
 void loop() {
+  DetentEvent event;
+  while(decoder.pop(event))
+    encoder_handlers[event.id]->detent(event.direction, event.time);
+
   encoder_handlerA.step();
   encoder_handlerB.step();
   encoder_handlerC.step();
@@ -2,7 +2,7 @@
 #define __ENCODER_HANDLER_H__
 
 #include <Arduino.h>
-#include <limits.h>
+#include "tx_queue.h"
 
 #define UNPRESSED 0
 #define PRESSED 1
@@ -12,22 +12,26 @@
 class EncoderHandler
 {
 public:
-  EncoderHandler(byte id, int clock_pin, int data_pin, int button_pin, byte pulses_per_detent=1){
+  EncoderHandler(byte id, int button_pin, TxQueue *tx){
     _id = id;
     _button_pin = button_pin;
-    _pulses_per_detent = pulses_per_detent;
+    _tx = tx;
 
-    old_dial_position = LONG_MIN;
-    old_encoded_position = LONG_MIN;
+    pending_detents = 0;
+    pending_since = 0;
+    next_send_time = 0;
     button_state = UNPRESSED;
     valid_time = 0;
 
     pinMode(_button_pin, INPUT_PULLUP);
+  }
 
-    if(clock_pin != 0 && data_pin != 0)
-      pencoder = new Encoder(clock_pin, data_pin);
-    else
-      pencoder = NULL;
+  // a detent from the decoder queue, time is the micros() when the ISR saw it
+  // counts go out as turned, the audio board scales them for what the knob edits
+  void detent(int direction, unsigned long time){
+    if(pending_detents == 0)
+      pending_since = time;
+    pending_detents += direction;
   }
 
   void step(){
@@ -43,6 +47,8 @@ public:
           button_state = UNPRESSED;
         } else {
           if(millis() >= valid_time){
+            if(pending_detents != 0)
+              send_detents();
             send(0);
             valid_time = millis() + REPEAT_TIME;
             button_state = NOTIFIED_PRESSED;        
@@ -67,41 +73,54 @@ public:
       //   break;
     }
 
-    if(pencoder != NULL){    
-      long new_dial_position = pencoder->read();
-      if (new_dial_position != old_dial_position) {
-        int diff = new_dial_position - old_dial_position;
-        old_dial_position = new_dial_position;
-        
-        if(diff != 0){
-          long new_encoded_position = new_dial_position / _pulses_per_detent;
-          if(new_encoded_position != old_encoded_position){
-            old_encoded_position = new_encoded_position;
-            send(diff);      
-          }
-        }
-      }
-    }
+    // the first detent goes out at once, detents arriving within
+    // COALESCE_TIME of a send are summed into the next one
+    if(pending_detents != 0 && (long)(millis() - next_send_time) >= 0)
+      send_detents();
+  }
+
+  void send_detents(){
+    int detents = constrain(pending_detents, -LINK_MAX_DELTA, LINK_MAX_DELTA);
+    pending_detents -= detents;
+    next_send_time = millis() + COALESCE_TIME;
+
+    if(detents == -1 || detents == 1)
+      send(detents);
+    else
+      send_delta(detents);
   }
-  
+
   // diff is -1 for CCW, 1 for CW, 0 for button press, 2 for button repeat
-  // sent is: 0 for CCW, 2 for CW, 1 for button press, 3 for button repeat
   void send(int diff){
-    char buffer[5];
-    sprintf(buffer, "%d%d", _id, diff + 1);
-    Serial.println(buffer);
+    switch(diff){
+      case 0:
+        _tx->push(_id, LINK_PRESS, 0, micros());
+        break;
+      case 2:
+        _tx->push(_id, LINK_REPEAT, 0, micros());
+        break;
+      default:
+        _tx->push(_id, LINK_TURN, diff, pending_since);
+        break;
+    }
+  }
+
+  // several detents in one frame, stamped with the first of them
+  void send_delta(int detents){
+    _tx->push(_id, LINK_TURN, detents, pending_since);
   }
 
   const int DEBOUNCE_TIME = 50;
   const int REPEAT_TIME = 500;
+  const int COALESCE_TIME = 20;
 
 private:  
   byte _id;
   byte _button_pin;
-  byte _pulses_per_detent;
-  Encoder * pencoder;
-  long old_dial_position;
-  long old_encoded_position;
+  TxQueue *_tx;
+  long pending_detents;
+  unsigned long pending_since;  // micros() of the oldest detent not yet sent
+  unsigned long next_send_time;
 
   byte button_state;  
   unsigned long valid_time;
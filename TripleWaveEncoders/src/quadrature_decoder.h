@@ -0,0 +1,187 @@
+#ifndef __QUADRATURE_DECODER_H__
+#define __QUADRATURE_DECODER_H__
+
+#include <Arduino.h>
+
+// a detent seen by the timer interrupt, direction is -1 or 1, time is micros()
+struct DetentEvent {
+  byte id;
+  int8_t direction;
+  unsigned long time;
+};
+
+// Decodes all encoders from a fixed rate timer interrupt
+// Each tick reads every input port in use once and decodes all the clock/data pairs on it
+// together with a few byte wide operations, so a tick costs the same however many
+// encoders there are. The transition table of the Encoder library reduces to two rules:
+// a pair steps when exactly one of its bits changed, and the step is up when the new
+// clock equals the old data; skipped states and no change count 0.
+// Only encoders that stepped are then visited to count pulses into detents. Whole detents
+// are timestamped and queued for loop(); the ISR is the only producer and loop() the only
+// consumer, so the queue needs no locking.
+// An encoder's data pin must be the next bit up from its clock pin on the same port.
+class QuadratureDecoder
+{
+public:
+  QuadratureDecoder(){
+    num_ports = 0;
+    num_encoders = 0;
+    head = 0;
+    tail = 0;
+    dropped = 0;
+  }
+
+  // returns false if the pins cannot be decoded
+  bool add(byte id, byte clock_pin, byte data_pin, byte pulses_per_detent=1){
+    byte port = digitalPinToPort(clock_pin);
+    byte clock_mask = digitalPinToBitMask(clock_pin);
+    if(num_encoders >= MAX_ENCODERS || port == NOT_A_PIN ||
+      digitalPinToPort(data_pin) != port || digitalPinToBitMask(data_pin) != (clock_mask << 1))
+      return false;
+
+    byte slot = 0;
+    while(slot < num_ports && ports[slot].number != port)
+      slot++;
+    if(slot == num_ports){
+      if(num_ports >= MAX_PORTS)
+        return false;
+      ports[slot].number = port;
+      ports[slot].input = portInputRegister(port);
+      ports[slot].mask = 0;
+      ports[slot].clocks = 0;
+      num_ports++;
+    }
+    ports[slot].mask |= clock_mask | (clock_mask << 1);
+    ports[slot].clocks |= clock_mask;
+
+    pinMode(clock_pin, INPUT_PULLUP);
+    pinMode(data_pin, INPUT_PULLUP);
+
+    byte shift = 0;
+    while(!(clock_mask & 1)){
+      clock_mask >>= 1;
+      shift++;
+    }
+    ports[slot].encoders[shift] = num_encoders;
+
+    Encoder *encoder = &encoders[num_encoders++];
+    encoder->id = id;
+    encoder->pulses_per_detent = pulses_per_detent;
+    encoder->pulses = 0;
+    return true;
+  }
+
+  // Timer2 in CTC mode at TICK_US, call after the encoders are added
+  void begin(){
+    for(byte i = 0; i < num_ports; i++)
+      ports[i].last = *ports[i].input & ports[i].mask;
+
+    noInterrupts();
+    TCCR2A = _BV(WGM21);
+    TCCR2B = _BV(CS22);
+    OCR2A = F_CPU / 64 / (1000000UL / TICK_US) - 1;
+    TCNT2 = 0;
+    TIMSK2 |= _BV(OCIE2A);
+    interrupts();
+  }
+
+  // from the timer interrupt only
+  // every mask below has a bit at each encoder's clock position, for all pairs at once
+  void tick(){
+    for(byte i = 0; i < num_ports; i++){
+      Port *port = &ports[i];
+      byte sample = *port->input & port->mask;
+      byte changed = sample ^ port->last;
+      if(changed == 0)
+        continue;
+
+      byte stepped = (changed ^ (changed >> 1)) & port->clocks;
+      byte down = (sample ^ (port->last >> 1)) & stepped;
+      port->last = sample;
+
+      for(byte shift = 0; stepped != 0; shift++, stepped >>= 1, down >>= 1){
+        if(stepped & 1)
+          count(&encoders[port->encoders[shift]], down & 1 ? -1 : 1);
+      }
+    }
+  }
+
+  // from loop() only, returns false when the queue is empty
+  bool pop(DetentEvent &event){
+    byte index = tail;
+    if(index == head)
+      return false;
+    // the entry is read only after head shows it is complete
+    asm volatile("" ::: "memory");
+    event = queue[index];
+    tail = (index + 1) & (QUEUE_SIZE - 1);
+    return true;
+  }
+
+  // detents lost to a full queue
+  unsigned int dropped_count(){
+    noInterrupts();
+    unsigned int count = dropped;
+    interrupts();
+    return count;
+  }
+
+  static const byte MAX_ENCODERS = 4;
+  static const byte MAX_PORTS = 3;
+  static const byte QUEUE_SIZE = 16;        // a power of two
+  static const unsigned int TICK_US = 200;  // 5 kHz, several samples per edge at full speed
+
+private:
+  struct Port {
+    byte number;
+    volatile uint8_t *input;
+    byte mask;    // clock and data bits of the encoders on this port
+    byte clocks;  // clock bits only
+    byte last;
+    byte encoders[8];   // by clock bit number, data is the next bit
+  };
+
+  struct Encoder {
+    byte id;
+    byte pulses_per_detent;
+    int8_t pulses;
+  };
+
+  void count(Encoder *encoder, int8_t pulse){
+    encoder->pulses += pulse;
+    if(encoder->pulses >= (int8_t)encoder->pulses_per_detent){
+      encoder->pulses -= encoder->pulses_per_detent;
+      push(encoder->id, 1);
+    } else if(encoder->pulses <= -(int8_t)encoder->pulses_per_detent){
+      encoder->pulses += encoder->pulses_per_detent;
+      push(encoder->id, -1);
+    }
+  }
+
+  void push(byte id, int8_t direction){
+    byte index = head;
+    byte next = (index + 1) & (QUEUE_SIZE - 1);
+    if(next == tail){
+      dropped++;
+      return;
+    }
+    queue[index].id = id;
+    queue[index].direction = direction;
+    queue[index].time = micros();
+    // the entry is complete before head moves past it
+    asm volatile("" ::: "memory");
+    head = next;
+  }
+
+  Port ports[MAX_PORTS];
+  byte num_ports;
+  Encoder encoders[MAX_ENCODERS];
+  byte num_encoders;
+
+  DetentEvent queue[QUEUE_SIZE];
+  volatile byte head;   // written by the ISR
+  volatile byte tail;   // written by loop()
+  volatile unsigned int dropped;
+};
+
+#endif
@@ -0,0 +1,157 @@
+#ifndef __TX_QUEUE_H__
+#define __TX_QUEUE_H__
+
+#include <Arduino.h>
+#include <link_frame.h>
+
+// Outgoing frames to the audio board, sent from the USART data register empty interrupt
+// push() encodes a link frame into a preallocated slot and returns at once, it never
+// waits for the line. Each frame queued takes the next sequence number.
+// When frames are backed up, a turn can be merged into the newest waiting frame of the
+// same encoder; if the queue is full the new frame is dropped and counted.
+// Built with TRACE_LATENCY, every turn is followed by a latency frame that is filled in
+// as it starts to go out, by which time the turn itself is on the wire.
+// This takes over USART0, Serial must not be used alongside it.
+class TxQueue
+{
+public:
+  TxQueue(){
+    head = 0;
+    tail = 0;
+    position = 0;
+    policy = POLICY_MERGE;
+    sequence = 0;
+    dropped = 0;
+    merged = 0;
+  }
+
+  void begin(unsigned long baud){
+    UCSR0A = _BV(U2X0);
+    UBRR0 = (F_CPU / 8 / baud) - 1;
+    UCSR0C = _BV(UCSZ01) | _BV(UCSZ00);
+    UCSR0B = _BV(TXEN0);
+  }
+
+  void set_policy(byte new_policy){
+    policy = new_policy;
+  }
+
+  // type is one of the LINK_ frame types, detents is the signed turn or 0,
+  // stamp is the micros() of the event
+  bool push(byte id, byte type, int8_t detents=0, unsigned long stamp=0){
+#ifdef TRACE_LATENCY
+    if(type == LINK_TURN)
+      return queue(id, type, detents, stamp) && queue(id, LINK_LATENCY, 0, stamp);
+#endif
+    return queue(id, type, detents, stamp);
+  }
+
+  // from the USART_UDRE interrupt only
+  void drain(){
+    if(head == tail){
+      UCSR0B &= ~_BV(UDRIE0);
+      return;
+    }
+
+    Frame *frame = &frames[tail];
+    if(position == 0 && frame->type == LINK_LATENCY){
+      unsigned long latency = (micros() - frame->stamp) / LINK_LATENCY_UNIT_US;
+      link_encode(frame->bytes, LINK_LATENCY, frame->id, (int8_t)(latency > 255 ? 255 : latency), frame->sequence);
+    }
+
+    UDR0 = frame->bytes[position++];
+    if(position == LINK_FRAME_SIZE){
+      position = 0;
+      tail = (tail + 1) & (QUEUE_SIZE - 1);
+      if(head == tail)
+        UCSR0B &= ~_BV(UDRIE0);
+    }
+  }
+
+  unsigned int dropped_count(){
+    noInterrupts();
+    unsigned int count = dropped;
+    interrupts();
+    return count;
+  }
+
+  unsigned int merged_count(){
+    noInterrupts();
+    unsigned int count = merged;
+    interrupts();
+    return count;
+  }
+
+  static const byte POLICY_DROP = 0;    // every frame is sent as pushed, dropped when full
+  static const byte POLICY_MERGE = 1;   // waiting turns of one encoder are summed
+
+  static const byte QUEUE_SIZE = 16;    // a power of two
+
+private:
+  struct Frame {
+    byte id;
+    byte type;
+    int8_t detents;
+    byte sequence;
+    unsigned long stamp;
+    byte bytes[LINK_FRAME_SIZE];
+  };
+
+  // a latency frame carries the sequence number of the turn it follows
+  bool queue(byte id, byte type, int8_t detents, unsigned long stamp){
+    noInterrupts();
+    if(policy == POLICY_MERGE && type == LINK_TURN && head != tail){
+      // the frame at tail may be going out already, anything after it is still waiting
+      byte newest = (head - 1) & (QUEUE_SIZE - 1);
+      Frame *frame = &frames[newest];
+      int sum = frame->detents + detents;
+      if(newest != tail && frame->id == id && frame->type == LINK_TURN &&
+        (frame->detents < 0) == (detents < 0) && sum >= -LINK_MAX_DELTA && sum <= LINK_MAX_DELTA){
+        frame->detents = sum;
+        link_encode(frame->bytes, LINK_TURN, id, sum, frame->sequence);
+        merged++;
+        interrupts();
+        return true;
+      }
+    }
+
+    byte next = (head + 1) & (QUEUE_SIZE - 1);
+    if(next == tail){
+      dropped++;
+      interrupts();
+      return false;
+    }
+    interrupts();
+
+    // the slot at head is not seen by the interrupt until head moves past it
+    Frame *frame = &frames[head];
+    frame->id = id;
+    frame->type = type;
+    frame->detents = detents;
+    frame->stamp = stamp;
+    if(type == LINK_LATENCY){
+      frame->sequence = (sequence - 1) & LINK_SEQUENCE_MASK;
+    } else {
+      frame->sequence = sequence;
+      sequence = (sequence + 1) & LINK_SEQUENCE_MASK;
+    }
+    link_encode(frame->bytes, type, id, detents, frame->sequence);
+
+    noInterrupts();
+    head = next;
+    UCSR0B |= _BV(UDRIE0);
+    interrupts();
+    return true;
+  }
+
+  Frame frames[QUEUE_SIZE];
+  volatile byte head;       // written by queue()
+  volatile byte tail;       // written by the interrupt
+  byte position;            // next byte of the frame at tail
+  byte policy;
+  byte sequence;            // of the next frame queued
+  unsigned int dropped;
+  unsigned int merged;
+};
+
+#endif
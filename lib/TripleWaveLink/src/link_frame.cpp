@@ -0,0 +1,109 @@
+#include "link_frame.h"
+
+#define NO_SEQUENCE (LINK_SEQUENCE_MASK + 1)
+
+byte link_crc8(const byte *data, byte length){
+	byte crc = 0;
+	while(length--){
+		crc ^= *data++;
+		for(byte bit = 0; bit < 8; bit++)
+			crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+	}
+	return crc;
+}
+
+void link_encode(byte *frame, byte type, byte id, int8_t value, byte sequence){
+	frame[0] = LINK_SYNC;
+	frame[1] = (type << 6) | ((id & LINK_MAX_ID) << 4) | (sequence & LINK_SEQUENCE_MASK);
+	frame[2] = (byte)value;
+	frame[3] = link_crc8(frame, LINK_FRAME_SIZE - 1);
+}
+
+LinkReceiver::LinkReceiver(){
+	_length = 0;
+	_expected = NO_SEQUENCE;
+	reset_counts();
+}
+
+// returns true when c completes a good frame
+bool LinkReceiver::receive(byte c){
+	if(_length == 0 && c != LINK_SYNC){
+		_skipped++;
+		return false;
+	}
+
+	_frame[_length++] = c;
+	if(_length < LINK_FRAME_SIZE)
+		return false;
+
+	if(link_crc8(_frame, LINK_FRAME_SIZE - 1) != _frame[LINK_FRAME_SIZE - 1]){
+		_crc_errors++;
+		resync();
+		return false;
+	}
+
+	if(type() != LINK_LATENCY){
+		byte sequence = _frame[1] & LINK_SEQUENCE_MASK;
+		if(_expected != NO_SEQUENCE)
+			_lost += (sequence - _expected) & LINK_SEQUENCE_MASK;
+		_expected = (sequence + 1) & LINK_SEQUENCE_MASK;
+	}
+
+	_frames++;
+	_length = 0;
+	return true;
+}
+
+// true while part of a frame is held
+bool LinkReceiver::receiving(){
+	return _length != 0;
+}
+
+byte LinkReceiver::type(){
+	return _frame[1] >> 6;
+}
+
+byte LinkReceiver::id(){
+	return (_frame[1] >> 4) & LINK_MAX_ID;
+}
+
+int8_t LinkReceiver::value(){
+	return (int8_t)_frame[2];
+}
+
+byte LinkReceiver::sequence(){
+	return _frame[1] & LINK_SEQUENCE_MASK;
+}
+
+unsigned int LinkReceiver::frame_count(){
+	return _frames;
+}
+
+unsigned int LinkReceiver::crc_error_count(){
+	return _crc_errors;
+}
+
+unsigned int LinkReceiver::lost_count(){
+	return _lost;
+}
+
+unsigned int LinkReceiver::skipped_count(){
+	return _skipped;
+}
+
+void LinkReceiver::reset_counts(){
+	_frames = 0;
+	_crc_errors = 0;
+	_lost = 0;
+	_skipped = 0;
+}
+
+// a later sync byte in the bad frame may be the start of the real one
+void LinkReceiver::resync(){
+	byte start = 1;
+	while(start < LINK_FRAME_SIZE && _frame[start] != LINK_SYNC)
+		start++;
+	_skipped += start;
+	_length = LINK_FRAME_SIZE - start;
+	memmove(_frame, _frame + start, _length);
+}
@@ -0,0 +1,66 @@
+#ifndef __LINK_FRAME_H__
+#define __LINK_FRAME_H__
+
+#include <Arduino.h>
+
+// Binary frames from the encoder board to the audio board, four bytes each:
+//	0	LINK_SYNC
+//	1	type << 6 | id << 4 | sequence
+//	2	value, the signed detent count of a turn, 0 otherwise
+//	3	CRC-8 of bytes 0-2, polynomial 0x07
+// The sync byte is outside ASCII, so typed text commands can share the line.
+#define LINK_SYNC 0xA5
+#define LINK_FRAME_SIZE 4
+
+// frame types
+#define LINK_TURN 0
+#define LINK_PRESS 1
+#define LINK_REPEAT 2
+#define LINK_LATENCY 3	// follows a traced frame and carries its sequence number, the value is
+												// the unsigned time from the detent to the frame being sent
+#define LINK_LATENCY_UNIT_US 100
+
+#define LINK_MAX_ID 3
+#define LINK_MAX_DELTA 127	// the most detents one turn frame carries either way, the value is an int8_t
+#define LINK_SEQUENCE_MASK 0x0f
+
+byte link_crc8(const byte *data, byte length);
+void link_encode(byte *frame, byte type, byte id, int8_t value, byte sequence);
+
+// Reassembles frames from a byte stream
+// Bytes before a sync byte are skipped, a frame with a bad CRC is dropped and the
+// search for the next sync byte restarts inside it. Sequence numbers that jump
+// count the frames lost in between; latency frames reuse a number and are not counted.
+class LinkReceiver
+{
+public:
+	LinkReceiver();
+
+	bool receive(byte c);
+	bool receiving();
+
+	byte type();
+	byte id();
+	int8_t value();
+	byte sequence();
+
+	unsigned int frame_count();
+	unsigned int crc_error_count();
+	unsigned int lost_count();
+	unsigned int skipped_count();
+	void reset_counts();
+
+private:
+	void resync();
+
+	byte _frame[LINK_FRAME_SIZE];
+	byte _length;
+	byte _expected;		// next sequence number, LINK_SEQUENCE_MASK + 1 before the first frame
+
+	unsigned int _frames;
+	unsigned int _crc_errors;
+	unsigned int _lost;
+	unsigned int _skipped;
+};
+
+#endif
@@ -0,0 +1,48 @@
+# PlatformIO post-build step: reports flash and SRAM use of the firmware and fails the
+# build when the SRAM left for the stack (and heap) drops below the env's
+# custom_min_stack_headroom, in bytes.
+#
+#   extra_scripts = post:../scripts/memory_budget.py
+#   custom_min_stack_headroom = 256
+
+import subprocess
+import sys
+
+Import("env")
+
+board = env.BoardConfig()
+RAM_SIZE = int(board.get("upload.maximum_ram_size", 2048))
+FLASH_SIZE = int(board.get("upload.maximum_size", 30720))
+
+
+def section_sizes(elf):
+    # avr-size -A lists "name size address" per section
+    lines = subprocess.check_output([env.subst("$SIZETOOL"), "-A", elf]).decode().splitlines()
+    sizes = {}
+    for line in lines:
+        fields = line.split()
+        if len(fields) >= 2 and fields[0].startswith(".") and fields[1].isdigit():
+            sizes[fields[0]] = int(fields[1])
+    return sizes
+
+
+def memory_budget(source, target, env):
+    sizes = section_sizes(str(target[0]))
+    data = sizes.get(".data", 0)
+    bss = sizes.get(".bss", 0)
+    text = sizes.get(".text", 0)
+    headroom = RAM_SIZE - data - bss
+    minimum = int(env.GetProjectOption("custom_min_stack_headroom", "0"))
+
+    print("memory budget for %s" % env["PIOENV"])
+    print("  flash  %6d of %6d bytes (.text + .data)" % (text + data, FLASH_SIZE))
+    print("  .data  %6d bytes" % data)
+    print("  .bss   %6d bytes" % bss)
+    print("  stack  %6d bytes of headroom, minimum %d" % (headroom, minimum))
+
+    if headroom < minimum:
+        sys.stderr.write("error: %d bytes of SRAM left for the stack, custom_min_stack_headroom is %d\n" % (headroom, minimum))
+        env.Exit(1)
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", memory_budget)